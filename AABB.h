@@ -0,0 +1,84 @@
+/*----------------------------------------------------------
+* COSC363  Ray Tracer
+*
+*  The axis-aligned bounding box class
+*  Every scene object reports its extent as an AABB, which
+*  the BVH uses to skip objects a ray cannot possibly hit.
+-------------------------------------------------------------*/
+
+#ifndef H_AABB
+#define H_AABB
+
+#include <glm/glm.hpp>
+
+struct AABB
+{
+	glm::vec3 min = glm::vec3(1.e+30f);		//An empty box: any point expands it
+	glm::vec3 max = glm::vec3(-1.e+30f);
+
+	AABB() {}
+
+	AABB(glm::vec3 lo, glm::vec3 hi) : min(lo), max(hi) {}
+
+	void expand(glm::vec3 p)
+	{
+		min = glm::min(min, p);
+		max = glm::max(max, p);
+	}
+
+	void expand(const AABB& box)
+	{
+		min = glm::min(min, box.min);
+		max = glm::max(max, box.max);
+	}
+
+	//Grows the box by eps on every side, so that flat objects such as planes still have volume
+	void pad(float eps)
+	{
+		min = min - glm::vec3(eps);
+		max = max + glm::vec3(eps);
+	}
+
+	bool contains(glm::vec3 p) const
+	{
+		return p.x >= min.x && p.y >= min.y && p.z >= min.z && p.x <= max.x && p.y <= max.y && p.z <= max.z;
+	}
+
+	//Whether the boxes share any point; an empty box overlaps nothing
+	bool overlaps(const AABB& box) const
+	{
+		return min.x <= box.max.x && min.y <= box.max.y && min.z <= box.max.z
+			&& max.x >= box.min.x && max.y >= box.min.y && max.z >= box.min.z;
+	}
+
+	glm::vec3 centroid() const
+	{
+		return (min + max) * 0.5f;
+	}
+
+	float surfaceArea() const
+	{
+		glm::vec3 e = max - min;
+		if (e.x < 0 || e.y < 0 || e.z < 0) return 0;
+		return 2 * (e.x * e.y + e.y * e.z + e.z * e.x);
+	}
+
+	/**
+	* Slab test against the ray p0 + t*dir, given invDir = 1/dir.
+	* Returns the entry distance (clamped to 0), or -1 if the ray misses the box
+	* or only reaches it beyond tmax.
+	*/
+	float intersect(glm::vec3 p0, glm::vec3 invDir, float tmax) const
+	{
+		glm::vec3 t1 = (min - p0) * invDir;
+		glm::vec3 t2 = (max - p0) * invDir;
+		glm::vec3 tlo = glm::min(t1, t2);
+		glm::vec3 thi = glm::max(t1, t2);
+		float tnear = glm::max(glm::max(tlo.x, tlo.y), glm::max(tlo.z, 0.0f));
+		float tfar = glm::min(glm::min(thi.x, thi.y), glm::min(thi.z, tmax));
+		if (tnear > tfar) return -1;
+		return tnear;
+	}
+};
+
+#endif //!H_AABB
@@ -0,0 +1,98 @@
+/*----------------------------------------------------------
+* COSC363  Ray Tracer
+*
+*  The animation class
+*  See Animation.h.
+-------------------------------------------------------------*/
+
+#include "Animation.h"
+#include <algorithm>
+
+/**
+* Gathers the scene file's keys into one track per keyed item. Must be called after
+* the scene file has created its objects, which the instance tracks move.
+*/
+void Animation::build(const SceneFile& sceneFile, const std::vector<SceneObject*>& sceneObjects)
+{
+	tracks_.clear();
+	for (int i = 0; i < sceneFile.getNumKeys(); i++)
+	{
+		const KeyRecord& key = sceneFile.getKey(i);
+		size_t t = 0;
+		while (t < tracks_.size() && (tracks_[t].target != key.target || (key.target != KEY_CAMERA && tracks_[t].keys[0].index != key.index))) t++;
+		if (t == tracks_.size())
+		{
+			Track track;
+			track.target = key.target;
+			track.index = key.index;
+			if (key.target == KEY_INSTANCE)
+			{
+				track.instance = dynamic_cast<Instance*>(sceneFile.getCreatedObject(key.index));
+				if (track.instance == nullptr) continue;
+				track.base = track.instance->getTransform();
+				track.index = std::find(sceneObjects.begin(), sceneObjects.end(), track.instance) - sceneObjects.begin();
+			}
+			tracks_.push_back(track);
+		}
+		tracks_[t].keys.push_back(key);
+	}
+	for (size_t t = 0; t < tracks_.size(); t++)
+		std::stable_sort(tracks_[t].keys.begin(), tracks_[t].keys.end(),
+			[](const KeyRecord& a, const KeyRecord& b) { return a.frame < b.frame; });
+}
+
+//The keys' values at 'frame': linear between the keys either side, held beyond the first and last
+KeyRecord Animation::interpolate(const std::vector<KeyRecord>& keys, float frame)
+{
+	if (frame <= keys.front().frame) return keys.front();
+	if (frame >= keys.back().frame) return keys.back();
+	size_t k = 1;
+	while (keys[k].frame < frame) k++;
+	const KeyRecord& a = keys[k - 1];
+	const KeyRecord& b = keys[k];
+	float s = (b.frame > a.frame) ? (frame - a.frame) / (b.frame - a.frame) : 1;
+	KeyRecord key = a;
+	for (int i = 0; i < 3; i++)
+	{
+		key.translate[i] = a.translate[i] + s * (b.translate[i] - a.translate[i]);
+		key.scale[i] = a.scale[i] + s * (b.scale[i] - a.scale[i]);
+	}
+	for (int i = 0; i < 4; i++) key.rotate[i] = a.rotate[i] + s * (b.rotate[i] - a.rotate[i]);
+	key.frame = frame;
+	return key;
+}
+
+/**
+* Moves the keyed camera eye, lights and instances to where they are at 'frame'.
+* The scene objects and lights that have actually moved are listed in movedObjects
+* and movedLights (by index), so the caller can refit the scene and mark what needs
+* to be traced again.
+*/
+void Animation::apply(float frame, glm::vec3& eye, std::vector<Light>& lights, std::vector<int>& movedObjects, std::vector<int>& movedLights)
+{
+	movedObjects.clear();
+	movedLights.clear();
+	for (size_t t = 0; t < tracks_.size(); t++)
+	{
+		const Track& track = tracks_[t];
+		KeyRecord key = interpolate(track.keys, frame);
+		glm::vec3 position(key.translate[0], key.translate[1], key.translate[2]);
+		if (track.target == KEY_CAMERA) eye = position;
+		else if (track.target == KEY_LIGHT)
+		{
+			if (track.index >= (int)lights.size() || lights[track.index].position == position) continue;
+			lights[track.index].position = position;
+			movedLights.push_back(track.index);
+		}
+		else
+		{
+			glm::mat4 motion = Instance::rotation(key.rotate[0], glm::vec3(key.rotate[1], key.rotate[2], key.rotate[3]));
+			for (int i = 0; i < 3; i++) motion[i] *= key.scale[i];
+			motion[3] = glm::vec4(position, 1);
+			glm::mat4 toWorld = track.base * motion;
+			if (toWorld == track.instance->getTransform()) continue;
+			track.instance->setTransform(toWorld);
+			movedObjects.push_back(track.index);
+		}
+	}
+}
@@ -0,0 +1,48 @@
+/*----------------------------------------------------------
+* COSC363  Ray Tracer
+*
+*  The animation class
+*  Plays the keyframes of a scene file: for any frame it
+*  interpolates the keys of the camera, the lights and the
+*  instances, and moves them there. Only the keyed items
+*  change, so the textures, materials and everything else
+*  set up for the scene carry over from frame to frame.
+-------------------------------------------------------------*/
+
+#ifndef H_ANIMATION
+#define H_ANIMATION
+
+#include <glm/glm.hpp>
+#include <vector>
+#include "SceneFile.h"
+#include "SceneObject.h"
+#include "Instance.h"
+#include "Light.h"
+
+class Animation
+{
+private:
+	//The keys of one camera, light or instance, by frame
+	struct Track
+	{
+		int target = KEY_CAMERA;
+		int index = 0;					//Light: index in the lights. Instance: index in the scene objects
+		Instance* instance = nullptr;
+		glm::mat4 base = glm::mat4(1);	//The instance's own transform, from the scene file
+		std::vector<KeyRecord> keys;
+	};
+	std::vector<Track> tracks_;
+
+	static KeyRecord interpolate(const std::vector<KeyRecord>& keys, float frame);
+
+public:
+	Animation() {}
+
+	void build(const SceneFile& sceneFile, const std::vector<SceneObject*>& sceneObjects);
+
+	void apply(float frame, glm::vec3& eye, std::vector<Light>& lights, std::vector<int>& movedObjects, std::vector<int>& movedLights);
+
+	bool isEmpty() const { return tracks_.empty(); }
+};
+
+#endif //!H_ANIMATION
@@ -0,0 +1,199 @@
+/*----------------------------------------------------------
+* COSC363  Ray Tracer
+*
+*  The bounding volume hierarchy class
+*  A binary tree of AABBs built over the scene objects with
+*  the surface area heuristic (SAH). A ray only tests the
+*  objects in the leaves whose boxes it passes through, so
+*  the cost per ray grows with log(N) instead of N.
+*  The queries themselves run on the CompiledScene.
+-------------------------------------------------------------*/
+
+#include "BVH.h"
+#include <algorithm>
+
+const int NUM_BINS = 12;			//Number of candidate split planes per axis
+const int MAX_LEAF_SIZE = 4;		//Leaves larger than this are always split
+const float TRAVERSAL_COST = 1.0;	//Cost of visiting a node, relative to one intersection test
+const float BOX_EPS = 1.e-3;		//Padding so that flat objects get a box with some volume
+
+/**
+* Builds the tree over all objects in the scene. Must be called again
+* whenever objects are added to or moved in the scene.
+*/
+void BVH::build(std::vector<SceneObject*>& sceneObjects)
+{
+	std::vector<AABB> boxes(sceneObjects.size());
+	for (size_t i = 0; i < sceneObjects.size(); i++) boxes[i] = sceneObjects[i]->bounds();
+	build(boxes);
+}
+
+/**
+* Builds the tree over a list of boxes, e.g. the triangles of a mesh.
+* The leaves refer to positions in this list through getIndices().
+*/
+void BVH::build(const std::vector<AABB>& objectBoxes)
+{
+	nodes_.clear();
+	indices_.clear();
+
+	int n = objectBoxes.size();
+	std::vector<AABB> boxes(n);
+	std::vector<glm::vec3> centroids(n);
+	for (int i = 0; i < n; i++)
+	{
+		boxes[i] = objectBoxes[i];
+		boxes[i].pad(BOX_EPS);
+		centroids[i] = boxes[i].centroid();
+		indices_.push_back(i);
+	}
+	if (n == 0) return;
+
+	nodes_.reserve(2 * n);
+	buildNode(boxes, centroids, 0, n, 0);
+}
+
+//Recursively builds the subtree over indices_[start, start+count), with its root at the given depth, and returns its node index
+int BVH::buildNode(std::vector<AABB>& boxes, std::vector<glm::vec3>& centroids, int start, int count, int depth)
+{
+	int nodeIndex = nodes_.size();
+	nodes_.push_back(BVHNode());
+
+	AABB bounds, centroidBounds;
+	for (int i = start; i < start + count; i++)
+	{
+		bounds.expand(boxes[indices_[i]]);
+		centroidBounds.expand(centroids[indices_[i]]);
+	}
+	nodes_[nodeIndex].bounds = bounds;
+
+	//Find the cheapest split plane among the bin boundaries of all three axes
+	float leafCost = count;
+	float bestCost = 1.e+30f;
+	int bestAxis = -1, bestSplit = 0;
+	glm::vec3 extent = centroidBounds.max - centroidBounds.min;
+	for (int axis = 0; axis < 3 && count > 1; axis++)
+	{
+		if (extent[axis] <= 0) continue;
+		AABB binBoxes[NUM_BINS];
+		int binCounts[NUM_BINS] = { 0 };
+		for (int i = start; i < start + count; i++)
+		{
+			int obj = indices_[i];
+			int b = (int)(NUM_BINS * (centroids[obj][axis] - centroidBounds.min[axis]) / extent[axis]);
+			b = std::min(b, NUM_BINS - 1);
+			binCounts[b]++;
+			binBoxes[b].expand(boxes[obj]);
+		}
+
+		//Sweep from the right to get the area and count of everything above each boundary
+		float rightArea[NUM_BINS];
+		int rightCount[NUM_BINS];
+		AABB acc;
+		int accCount = 0;
+		for (int b = NUM_BINS - 1; b > 0; b--)
+		{
+			acc.expand(binBoxes[b]);
+			accCount += binCounts[b];
+			rightArea[b] = acc.surfaceArea();
+			rightCount[b] = accCount;
+		}
+
+		acc = AABB();
+		accCount = 0;
+		for (int b = 1; b < NUM_BINS; b++)
+		{
+			acc.expand(binBoxes[b - 1]);
+			accCount += binCounts[b - 1];
+			if (accCount == 0 || rightCount[b] == 0) continue;
+			float cost = TRAVERSAL_COST + (acc.surfaceArea() * accCount + rightArea[b] * rightCount[b]) / bounds.surfaceArea();
+			if (cost < bestCost)
+			{
+				bestCost = cost;
+				bestAxis = axis;
+				bestSplit = b;
+			}
+		}
+	}
+
+	if (bestAxis == -1 || (bestCost >= leafCost && count <= MAX_LEAF_SIZE) || depth >= BVH_STACK_SIZE - 1)
+	{
+		nodes_[nodeIndex].start = start;
+		nodes_[nodeIndex].count = count;
+		return nodeIndex;
+	}
+
+	int* first = &indices_[start];
+	int* mid = std::partition(first, first + count, [&](int obj)
+	{
+		int b = (int)(NUM_BINS * (centroids[obj][bestAxis] - centroidBounds.min[bestAxis]) / extent[bestAxis]);
+		return std::min(b, NUM_BINS - 1) < bestSplit;
+	});
+	int leftCount = mid - first;
+
+	buildNode(boxes, centroids, start, leftCount, depth + 1);
+	int right = buildNode(boxes, centroids, start + leftCount, count - leftCount, depth + 1);
+	nodes_[nodeIndex].start = right;
+	return nodeIndex;
+}
+
+/**
+* Updates the boxes of the tree for objects that have moved, keeping its shape:
+* far cheaper than a rebuild, but the tree gets worse as the objects drift from
+* where it was built for. boxes are the objects' new boxes, as given to build().
+*/
+void BVH::refit(const std::vector<AABB>& boxes)
+{
+	//Children come after their parent, so a backwards sweep sees them first
+	for (int node = (int)nodes_.size() - 1; node >= 0; node--)
+	{
+		BVHNode& n = nodes_[node];
+		AABB bounds;
+		if (n.count > 0)
+		{
+			for (int i = n.start; i < n.start + n.count; i++)
+			{
+				AABB box = boxes[indices_[i]];
+				box.pad(BOX_EPS);
+				bounds.expand(box);
+			}
+		}
+		else
+		{
+			bounds = nodes_[node + 1].bounds;
+			bounds.expand(nodes_[n.start].bounds);
+		}
+		n.bounds = bounds;
+	}
+}
+
+/**
+* The surface area heuristic cost of the tree: the expected number of node visits
+* and intersection tests of a ray through the root's box. Compared before and after
+* a refit, it tells when the tree has degraded enough to be worth rebuilding.
+*/
+float BVH::cost() const
+{
+	if (nodes_.empty()) return 0;
+	float rootArea = nodes_[0].bounds.surfaceArea();
+	if (rootArea <= 0) return 0;
+	float total = 0;
+	for (size_t node = 0; node < nodes_.size(); node++)
+		total += nodes_[node].bounds.surfaceArea() / rootArea * (nodes_[node].count > 0 ? nodes_[node].count : TRAVERSAL_COST);
+	return total;
+}
+
+int BVH::getNumNodes() const
+{
+	return nodes_.size();
+}
+
+const std::vector<BVHNode>& BVH::getNodes() const
+{
+	return nodes_;
+}
+
+const std::vector<int>& BVH::getIndices() const
+{
+	return indices_;
+}
@@ -0,0 +1,57 @@
+/*----------------------------------------------------------
+* COSC363  Ray Tracer
+*
+*  The bounding volume hierarchy class
+*  A binary tree of AABBs built over the scene objects with
+*  the surface area heuristic (SAH). A ray only tests the
+*  objects in the leaves whose boxes it passes through, so
+*  the cost per ray grows with log(N) instead of N.
+*  The queries themselves run on the CompiledScene.
+-------------------------------------------------------------*/
+
+#ifndef H_BVH
+#define H_BVH
+
+#include <glm/glm.hpp>
+#include <vector>
+#include "AABB.h"
+#include "SceneObject.h"
+
+//Entries of a traversal stack. A depth-first walk needs one more than the depth of the
+//deepest leaf, so build() makes a leaf of whatever is left at depth BVH_STACK_SIZE - 1.
+const int BVH_STACK_SIZE = 64;
+
+struct BVHNode
+{
+	AABB bounds;
+	int start = 0;		//Leaf: first entry in the index list.  Inner node: index of the right child
+	int count = 0;		//Number of objects in a leaf, 0 for an inner node (left child is the next node)
+};
+
+class BVH
+{
+private:
+	std::vector<BVHNode> nodes_;
+	std::vector<int> indices_;		//Object indices, grouped by leaf
+
+	int buildNode(std::vector<AABB>& boxes, std::vector<glm::vec3>& centroids, int start, int count, int depth);
+
+public:
+	BVH() {}
+
+	void build(std::vector<SceneObject*>& sceneObjects);
+
+	void build(const std::vector<AABB>& boxes);
+
+	void refit(const std::vector<AABB>& boxes);
+
+	float cost() const;
+
+	int getNumNodes() const;
+
+	const std::vector<BVHNode>& getNodes() const;
+
+	const std::vector<int>& getIndices() const;
+};
+
+#endif //!H_BVH
@@ -0,0 +1,508 @@
+/*----------------------------------------------------------
+* COSC363  Ray Tracer
+*
+*  The compiled scene class
+*  Flattens the scene objects into per-type tables and
+*  intersects rays with them through non-virtual loops.
+-------------------------------------------------------------*/
+
+#include "CompiledScene.h"
+#include "Sphere.h"
+#include "Plane.h"
+#include "Cylinder.h"
+#include "Cone.h"
+#include <math.h>
+
+const int CHUNK = 8;		//Table entries intersected per kernel call
+const float REBUILD_COST = 1.3;		//A refit BVH this much costlier than when it was built is rebuilt
+
+static const int tableColumns[NUM_PRIM_TYPES] = { SPHERE_COLUMNS, PLANE_COLUMNS, CYL_COLUMNS, CYL_COLUMNS, 0 };
+
+static int primType(SceneObject* obj)
+{
+	if (dynamic_cast<Sphere*>(obj)) return PRIM_SPHERE;
+	if (dynamic_cast<Plane*>(obj)) return PRIM_PLANE;
+	if (dynamic_cast<Cylinder*>(obj)) return PRIM_CYLINDER;
+	if (dynamic_cast<Cone*>(obj)) return PRIM_CONE;
+	return PRIM_OTHER;
+}
+
+/**
+* Compiles the scene: builds the BVH, then copies the geometry into the tables
+* in BVH leaf order (so each leaf refers to one contiguous run per table) and
+* the surface properties into the material table. Must be called again after
+* objects are added, moved or have their material changed.
+*/
+void CompiledScene::build(std::vector<SceneObject*>& sceneObjects)
+{
+	objects_ = &sceneObjects;
+	bvh_.build(sceneObjects);
+
+	int n = sceneObjects.size();
+	types_.assign(n, PRIM_OTHER);
+	slots_.assign(n, -1);
+	materials_.assign(n, Material());
+	int counts[NUM_PRIM_TYPES] = { 0 };
+	for (int i = 0; i < n; i++)
+	{
+		types_[i] = primType(sceneObjects[i]);
+		materials_[i] = sceneObjects[i]->getMaterial();
+		counts[types_[i]]++;
+	}
+	for (int type = 0; type < NUM_PRIM_TYPES; type++)
+	{
+		PrimTable& table = tables_[type];
+		table.count = counts[type];
+		table.columns = tableColumns[type];
+		table.data.assign(table.columns * table.count, 0);
+		table.object.assign(table.count, -1);
+		counts[type] = 0;		//From here on: next free entry
+	}
+
+	const std::vector<BVHNode>& nodes = bvh_.getNodes();
+	const std::vector<int>& indices = bvh_.getIndices();
+	leaves_.assign(nodes.size(), LeafRange());
+	for (int node = 0; node < (int)nodes.size(); node++)
+	{
+		if (nodes[node].count == 0) continue;
+		LeafRange& range = leaves_[node];
+		for (int type = 0; type < NUM_PRIM_TYPES; type++)
+		{
+			range.first[type] = counts[type];
+			for (int i = nodes[node].start; i < nodes[node].start + nodes[node].count; i++)
+			{
+				int obj = indices[i];
+				if (types_[obj] != type) continue;
+				slots_[obj] = counts[type]++;
+				addEntry(sceneObjects[obj], obj);
+			}
+			range.count[type] = counts[type] - range.first[type];
+		}
+	}
+	builtCost_ = bvh_.getNumNodes() > 0 ? bvh_.cost() : 0;
+}
+
+/**
+* Compiles the scene again after objects have moved, e.g. between the frames of an
+* animation: the BVH is refitted to the objects' new boxes and the tables updated in
+* place. The materials are kept. Once refitting has made the BVH more than
+* REBUILD_COST times as costly as it was when built, or if objects have been added,
+* it is built again instead. Returns whether it was.
+*/
+bool CompiledScene::refit(std::vector<SceneObject*>& sceneObjects)
+{
+	int n = sceneObjects.size();
+	if (objects_ != &sceneObjects || n != (int)types_.size() || bvh_.getNumNodes() == 0)
+	{
+		build(sceneObjects);
+		return true;
+	}
+	std::vector<AABB> boxes(n);
+	for (int i = 0; i < n; i++) boxes[i] = sceneObjects[i]->bounds();
+	bvh_.refit(boxes);
+	if (bvh_.cost() > REBUILD_COST * builtCost_)
+	{
+		build(sceneObjects);
+		return true;
+	}
+	for (int i = 0; i < n; i++)
+		if (types_[i] != PRIM_OTHER) addEntry(sceneObjects[i], i);
+	return false;
+}
+
+//Writes the geometry of one object into the next entry of its table
+void CompiledScene::addEntry(SceneObject* obj, int index)
+{
+	PrimTable& table = tables_[types_[index]];
+	int slot = slots_[index];
+	table.object[slot] = index;
+	float* d = table.data.data();
+	int stride = table.count;
+
+	if (Sphere* sphere = dynamic_cast<Sphere*>(obj))
+	{
+		glm::vec3 c = sphere->getCenter();
+		d[SPHERE_CX*stride + slot] = c.x;
+		d[SPHERE_CY*stride + slot] = c.y;
+		d[SPHERE_CZ*stride + slot] = c.z;
+		d[SPHERE_R*stride + slot] = sphere->getRadius();
+	}
+	else if (Plane* plane = dynamic_cast<Plane*>(obj))
+	{
+		glm::vec3 n = plane->normal(plane->getVertex(0));
+		d[PLANE_NX*stride + slot] = n.x;
+		d[PLANE_NY*stride + slot] = n.y;
+		d[PLANE_NZ*stride + slot] = n.z;
+		d[PLANE_D*stride + slot] = plane->getPlaneConstant();
+		for (int k = 0; k < 4; k++)
+		{
+			glm::vec4 e = plane->getEdge(k);
+			for (int j = 0; j < 4; j++) d[(PLANE_EDGES + 4*k + j)*stride + slot] = e[j];
+		}
+	}
+	else if (Cylinder* cylinder = dynamic_cast<Cylinder*>(obj))
+	{
+		glm::vec3 c = cylinder->getCenter();
+		d[CYL_CX*stride + slot] = c.x;
+		d[CYL_CY*stride + slot] = c.y;
+		d[CYL_CZ*stride + slot] = c.z;
+		d[CYL_R*stride + slot] = cylinder->getRadius();
+		d[CYL_H*stride + slot] = cylinder->getHeight();
+	}
+	else if (Cone* cone = dynamic_cast<Cone*>(obj))
+	{
+		glm::vec3 c = cone->getCenter();
+		d[CYL_CX*stride + slot] = c.x;
+		d[CYL_CY*stride + slot] = c.y;
+		d[CYL_CZ*stride + slot] = c.z;
+		d[CYL_R*stride + slot] = cone->getRadius();
+		d[CYL_H*stride + slot] = cone->getHeight();
+	}
+}
+
+//-- Intersection kernels ------------------------------------------------------------
+// Each computes the distance along the ray (p0, dir) to entries [first, first+n) of
+// a table, or a value <= 0 for a miss, with the same hit rules as the intersect()
+// method of the corresponding class. They have no early exits so that the loops
+// can be vectorized.
+//-------------------------------------------------------------------------------------
+static void intersectSpheres(const PrimTable& table, int first, int n, glm::vec3 p0, glm::vec3 dir, float* t)
+{
+	const float* cx = table.column(SPHERE_CX) + first;
+	const float* cy = table.column(SPHERE_CY) + first;
+	const float* cz = table.column(SPHERE_CZ) + first;
+	const float* r = table.column(SPHERE_R) + first;
+	for (int k = 0; k < n; k++)
+	{
+		float vx = p0.x - cx[k], vy = p0.y - cy[k], vz = p0.z - cz[k];
+		float b = dir.x * vx + dir.y * vy + dir.z * vz;
+		float len = sqrtf(vx * vx + vy * vy + vz * vz);
+		float c = len * len - r[k] * r[k];
+		float delta = b * b - c;
+		float root = sqrtf(delta > 0 ? delta : 0);
+		float t1 = -b - root;
+		float t2 = -b + root;
+		float tk = (fabsf(t1) < 0.001f) ? t2 : t1;		//Starting on the surface: take the far root
+		t[k] = (delta >= 0.001f) ? tk : -1;
+	}
+}
+
+static void intersectPlanes(const PrimTable& table, int first, int n, glm::vec3 p0, glm::vec3 dir, float* t)
+{
+	const float* nx = table.column(PLANE_NX) + first;
+	const float* ny = table.column(PLANE_NY) + first;
+	const float* nz = table.column(PLANE_NZ) + first;
+	const float* pd = table.column(PLANE_D) + first;
+	for (int k = 0; k < n; k++)
+	{
+		float dn = dir.x * nx[k] + dir.y * ny[k] + dir.z * nz[k];
+		float tk = (pd[k] - (p0.x * nx[k] + p0.y * ny[k] + p0.z * nz[k])) / dn;
+		float qx = p0.x + dir.x * tk, qy = p0.y + dir.y * tk, qz = p0.z + dir.z * tk;
+		bool pos = true, neg = true;
+		for (int e = 0; e < 4; e++)
+		{
+			const float* edge = table.column(PLANE_EDGES + 4*e) + first + k;
+			int stride = table.count;
+			float side = qx * edge[0] + qy * edge[stride] + qz * edge[2*stride] - edge[3*stride];
+			pos = pos && side > 0;
+			neg = neg && side < 0;
+		}
+		bool valid = fabsf(dn) >= 1.e-4f && fabsf(tk) >= 1.e-4f && (pos || neg);
+		t[k] = valid ? tk : -1;
+	}
+}
+
+static void intersectCylinders(const PrimTable& table, int first, int n, glm::vec3 p0, glm::vec3 dir, float* t)
+{
+	const float* cx = table.column(CYL_CX) + first;
+	const float* cy = table.column(CYL_CY) + first;
+	const float* cz = table.column(CYL_CZ) + first;
+	const float* r = table.column(CYL_R) + first;
+	const float* h = table.column(CYL_H) + first;
+	for (int k = 0; k < n; k++)
+	{
+		float vx = p0.x - cx[k], vz = p0.z - cz[k];
+		float a = dir.x * dir.x + dir.z * dir.z;
+		float b = 2 * (dir.x * vx + dir.z * vz);
+		float c = vx * vx + vz * vz - r[k] * r[k];
+		float delta = b * b - 4 * a * c;
+		float root = sqrtf(delta > 0 ? delta : 0);
+		float t1 = (-b - root) / (2 * a);
+		float t2 = (-b + root) / (2 * a);
+		float p1 = (t1 < t2) ? t1 : t2, p2 = (t1 < t2) ? t2 : t1;
+		float ytop = cy[k] + h[k];
+		float y1 = p0.y + p1 * dir.y, y2 = p0.y + p2 * dir.y;
+		bool side1 = y1 <= ytop && y1 >= cy[k];
+		bool side2 = y2 <= ytop && y2 >= cy[k];
+
+		//Cap: the ray crosses the top plane inside the rim
+		float tcap = (ytop - p0.y) / dir.y;
+		float capx = p0.x + tcap * dir.x - cx[k], capz = p0.z + tcap * dir.z - cz[k];
+		bool cap = side2 && tcap >= 0.001f && capx * capx + capz * capz <= r[k] * r[k];
+
+		bool valid = delta >= 0.001f && fabsf(t1) >= 0.001f && fabsf(t2) >= 0.001f && (side1 || cap);
+		t[k] = valid ? (side1 ? p1 : tcap) : -1;
+	}
+}
+
+static void intersectCones(const PrimTable& table, int first, int n, glm::vec3 p0, glm::vec3 dir, float* t)
+{
+	const float* cx = table.column(CYL_CX) + first;
+	const float* cy = table.column(CYL_CY) + first;
+	const float* cz = table.column(CYL_CZ) + first;
+	const float* r = table.column(CYL_R) + first;
+	const float* h = table.column(CYL_H) + first;
+	for (int k = 0; k < n; k++)
+	{
+		float ratio = r[k] / h[k];
+		float rh = ratio * ratio;
+		float vx = p0.x - cx[k], vz = p0.z - cz[k];
+		float hy = h[k] - p0.y + cy[k];
+		float a = dir.x * dir.x + dir.z * dir.z - rh * dir.y * dir.y;
+		float b = 2 * (dir.x * vx + dir.z * vz + rh * dir.y * hy);
+		float c = vx * vx + vz * vz - rh * hy * hy;
+		float delta = b * b - 4 * a * c;
+		float root = sqrtf(delta > 0 ? delta : 0);
+		float t1 = (-b - root) / (2 * a);
+		float t2 = (-b + root) / (2 * a);
+		float p1 = (t1 < t2) ? t1 : t2, p2 = (t1 < t2) ? t2 : t1;
+		float ytop = cy[k] + h[k];
+		float y1 = p0.y + p1 * dir.y, y2 = p0.y + p2 * dir.y;
+		bool side1 = y1 <= ytop && y1 >= cy[k];
+		bool side2 = y2 <= ytop && y2 >= cy[k];
+
+		bool valid = delta >= 0.001f && fabsf(t1) >= 0.001f && fabsf(t2) >= 0.001f && (side1 || side2);
+		t[k] = valid ? (side1 ? p1 : p2) : -1;
+	}
+}
+
+static void intersectTable(int type, const PrimTable& table, std::vector<SceneObject*>& objects,
+	int first, int n, glm::vec3 p0, glm::vec3 dir, float* t)
+{
+	switch (type)
+	{
+	case PRIM_SPHERE:   intersectSpheres(table, first, n, p0, dir, t); break;
+	case PRIM_PLANE:    intersectPlanes(table, first, n, p0, dir, t); break;
+	case PRIM_CYLINDER: intersectCylinders(table, first, n, p0, dir, t); break;
+	case PRIM_CONE:     intersectCones(table, first, n, p0, dir, t); break;
+	default:
+		for (int k = 0; k < n; k++) t[k] = objects[table.object[first + k]]->intersect(p0, dir);
+		break;
+	}
+}
+
+/**
+* Finds the closest object hit by the ray (p0, dir). On a hit, returns true
+* and sets index (position in the scene object list) and dist (distance along the ray).
+* Ties are resolved towards the lower index, as a linear scan of the list would.
+*/
+bool CompiledScene::closestHit(glm::vec3 p0, glm::vec3 dir, int& index, float& dist) const
+{
+	const std::vector<BVHNode>& nodes = bvh_.getNodes();
+	if (nodes.empty()) return false;
+	glm::vec3 invDir = glm::vec3(1) / dir;
+	float tmin = 1.e+6;
+	float t[CHUNK];
+	index = -1;
+
+	int stack[BVH_STACK_SIZE];
+	int top = 0;
+	stack[top++] = 0;
+	while (top > 0)
+	{
+		int nodeIndex = stack[--top];
+		const BVHNode& node = nodes[nodeIndex];
+		if (node.bounds.intersect(p0, invDir, tmin) < 0) continue;
+
+		if (node.count > 0)
+		{
+			const LeafRange& range = leaves_[nodeIndex];
+			for (int type = 0; type < NUM_PRIM_TYPES; type++)
+			{
+				const PrimTable& table = tables_[type];
+				for (int k0 = 0; k0 < range.count[type]; k0 += CHUNK)
+				{
+					int first = range.first[type] + k0;
+					int n = (range.count[type] - k0 < CHUNK) ? range.count[type] - k0 : CHUNK;
+					intersectTable(type, table, *objects_, first, n, p0, dir, t);
+					for (int k = 0; k < n; k++)
+					{
+						int obj = table.object[first + k];
+						if (t[k] > 0 && (t[k] < tmin || (t[k] == tmin && obj < index)))
+						{
+							tmin = t[k];
+							index = obj;
+						}
+					}
+				}
+			}
+		}
+		else
+		{
+			//Visit the nearer child first, so that tmin shrinks as early as possible
+			int left = nodeIndex + 1;
+			int right = node.start;
+			float tl = nodes[left].bounds.intersect(p0, invDir, tmin);
+			float tr = nodes[right].bounds.intersect(p0, invDir, tmin);
+			if (tl >= 0 && tr >= 0)
+			{
+				if (tr < tl) std::swap(left, right);
+				stack[top++] = right;	//far child, popped last
+				stack[top++] = left;	//near child, popped first
+			}
+			else if (tl >= 0) stack[top++] = left;
+			else if (tr >= 0) stack[top++] = right;
+		}
+	}
+
+	if (index == -1) return false;
+	dist = tmin;
+	return true;
+}
+
+/**
+* Any-hit query for shadow rays: reports whether an object lies on the ray (p0, dir)
+* closer than maxDist. Unlike closestHit() it does not search for the nearest object,
+* and it stops at the first opaque object found. Transparent objects do not end the
+* search, since an opaque object further along the segment still casts a full shadow.
+* If occluders is given, every object found is appended to it.
+*/
+Occlusion CompiledScene::occlusion(glm::vec3 p0, glm::vec3 dir, float maxDist, std::vector<int>* occluders) const
+{
+	const std::vector<BVHNode>& nodes = bvh_.getNodes();
+	if (nodes.empty()) return UNOCCLUDED;
+	glm::vec3 invDir = glm::vec3(1) / dir;
+	Occlusion result = UNOCCLUDED;
+	float t[CHUNK];
+
+	int stack[BVH_STACK_SIZE];
+	int top = 0;
+	stack[top++] = 0;
+	while (top > 0)
+	{
+		int nodeIndex = stack[--top];
+		const BVHNode& node = nodes[nodeIndex];
+		if (node.bounds.intersect(p0, invDir, maxDist) < 0) continue;
+
+		if (node.count > 0)
+		{
+			const LeafRange& range = leaves_[nodeIndex];
+			for (int type = 0; type < NUM_PRIM_TYPES; type++)
+			{
+				const PrimTable& table = tables_[type];
+				for (int k0 = 0; k0 < range.count[type]; k0 += CHUNK)
+				{
+					int first = range.first[type] + k0;
+					int n = (range.count[type] - k0 < CHUNK) ? range.count[type] - k0 : CHUNK;
+					intersectTable(type, table, *objects_, first, n, p0, dir, t);
+					for (int k = 0; k < n; k++)
+					{
+						if (t[k] <= 0 || t[k] >= maxDist) continue;
+						const Material& m = materials_[table.object[first + k]];
+						if (occluders != nullptr) occluders->push_back(table.object[first + k]);
+						if (!m.tran && !m.refr) return OCCLUDED_OPAQUE;
+						result = OCCLUDED_TRANSPARENT;
+					}
+				}
+			}
+		}
+		else
+		{
+			stack[top++] = node.start;
+			stack[top++] = nodeIndex + 1;
+		}
+	}
+	return result;
+}
+
+/**
+* Returns the unit normal vector of object 'index' at point p,
+* using the same formulas as the normal() methods of the classes.
+*/
+glm::vec3 CompiledScene::normal(int index, glm::vec3 p) const
+{
+	const PrimTable& table = tables_[types_[index]];
+	int slot = slots_[index];
+	switch (types_[index])
+	{
+	case PRIM_SPHERE:
+	{
+		glm::vec3 c(table.column(SPHERE_CX)[slot], table.column(SPHERE_CY)[slot], table.column(SPHERE_CZ)[slot]);
+		return glm::normalize(p - c);
+	}
+	case PRIM_PLANE:
+		return glm::vec3(table.column(PLANE_NX)[slot], table.column(PLANE_NY)[slot], table.column(PLANE_NZ)[slot]);
+	case PRIM_CYLINDER:
+	{
+		float cx = table.column(CYL_CX)[slot], cy = table.column(CYL_CY)[slot], cz = table.column(CYL_CZ)[slot];
+		if (p.y >= cy + table.column(CYL_H)[slot] - 0.01) return glm::vec3(0, 1, 0);
+		return glm::normalize(glm::vec3(p.x - cx, 0, p.z - cz));
+	}
+	case PRIM_CONE:
+	{
+		float cx = table.column(CYL_CX)[slot], cz = table.column(CYL_CZ)[slot];
+		float theta = atan(table.column(CYL_R)[slot] / table.column(CYL_H)[slot]);
+		float alpha = atan((p.x - cx) / (p.z - cz));
+		return glm::normalize(glm::vec3(sin(alpha)*cos(theta), sin(theta), cos(alpha)*cos(theta)));
+	}
+	default:
+		return (*objects_)[index]->normal(p);
+	}
+}
+
+/**
+* Returns the texture coordinates of object 'index' at point p. Only textured
+* hits need them, so they come from the object itself rather than the tables.
+*/
+glm::vec2 CompiledScene::texcoord(int index, glm::vec3 p) const
+{
+	return (*objects_)[index]->texcoord(p);
+}
+
+/**
+* For a ray starting inside object 'index': the distance to where it leaves the
+* object, and the normal there (see SceneObject::exit()). It is a closed-form
+* solve on the object alone, not a search of the scene: anything embedded in a
+* refractive object is not seen through it.
+*/
+float CompiledScene::exit(int index, glm::vec3 p0, glm::vec3 dir, glm::vec3& normalVec) const
+{
+	return (*objects_)[index]->exit(p0, dir, normalVec);
+}
+
+//Box around the whole scene; empty if there are no objects
+AABB CompiledScene::getBounds() const
+{
+	const std::vector<BVHNode>& nodes = bvh_.getNodes();
+	return nodes.empty() ? AABB() : nodes[0].bounds;
+}
+
+const Material& CompiledScene::getMaterial(int index) const
+{
+	return materials_[index];
+}
+
+int CompiledScene::getNumObjects() const
+{
+	return materials_.size();
+}
+
+const BVH& CompiledScene::getBVH() const
+{
+	return bvh_;
+}
+
+const PrimTable& CompiledScene::getTable(int type) const
+{
+	return tables_[type];
+}
+
+const std::vector<LeafRange>& CompiledScene::getLeaves() const
+{
+	return leaves_;
+}
+
+const std::vector<SceneObject*>& CompiledScene::getObjects() const
+{
+	return *objects_;
+}
@@ -0,0 +1,116 @@
+/*----------------------------------------------------------
+* COSC363  Ray Tracer
+*
+*  The compiled scene class
+*  The SceneObject classes are the authoring API. Once the
+*  scene is set up it is flattened into a CompiledScene:
+*  the geometry of each primitive type goes into its own
+*  structure-of-arrays table, the materials into a separate
+*  table indexed by object, and the BVH leaves refer to runs
+*  of each table. Rays are then intersected by plain loops
+*  over the tables instead of virtual calls per object.
+-------------------------------------------------------------*/
+
+#ifndef H_COMPILEDSCENE
+#define H_COMPILEDSCENE
+
+#include <glm/glm.hpp>
+#include <vector>
+#include "SceneObject.h"
+#include "Material.h"
+#include "BVH.h"
+
+//Result of an occlusion query: what, if anything, blocks the segment
+enum Occlusion
+{
+	UNOCCLUDED = 0,
+	OCCLUDED_TRANSPARENT,	//Only transparent or refractive objects lie on the segment
+	OCCLUDED_OPAQUE
+};
+
+enum PrimType
+{
+	PRIM_SPHERE = 0,
+	PRIM_PLANE,
+	PRIM_CYLINDER,
+	PRIM_CONE,
+	PRIM_OTHER,			//No table of its own: intersected through SceneObject::intersect()
+	NUM_PRIM_TYPES
+};
+
+//Columns of the primitive tables
+enum SphereColumn { SPHERE_CX = 0, SPHERE_CY, SPHERE_CZ, SPHERE_R, SPHERE_COLUMNS };
+enum PlaneColumn
+{
+	PLANE_NX = 0, PLANE_NY, PLANE_NZ,		//Unit normal
+	PLANE_D,								//Plane constant
+	PLANE_EDGES,							//4 edges x (in-plane edge normal xyz, offset), see Plane::precompute()
+	PLANE_COLUMNS = PLANE_EDGES + 16
+};
+enum CylinderColumn { CYL_CX = 0, CYL_CY, CYL_CZ, CYL_R, CYL_H, CYL_COLUMNS };	//Also used for cones
+
+//One structure-of-arrays table: column c of entry i is data[c*count + i]
+struct PrimTable
+{
+	int count = 0;
+	int columns = 0;
+	std::vector<float> data;
+	std::vector<int> object;		//Index of each entry's object in the scene object list
+
+	const float* column(int c) const { return data.data() + c * count; }
+};
+
+//The runs of each table that belong to one BVH leaf
+struct LeafRange
+{
+	int first[NUM_PRIM_TYPES];
+	int count[NUM_PRIM_TYPES];
+};
+
+class CompiledScene
+{
+private:
+	std::vector<SceneObject*>* objects_ = nullptr;
+	BVH bvh_;
+	PrimTable tables_[NUM_PRIM_TYPES];
+	std::vector<LeafRange> leaves_;		//Indexed by BVH node; only used for leaf nodes
+	std::vector<Material> materials_;	//Indexed by object
+	std::vector<int> types_;			//Indexed by object: its PrimType
+	std::vector<int> slots_;			//Indexed by object: its entry in the table of its type
+	float builtCost_ = 0;				//BVH cost when last built, see refit()
+
+	void addEntry(SceneObject* obj, int index);
+
+public:
+	CompiledScene() {}
+
+	void build(std::vector<SceneObject*>& sceneObjects);
+
+	bool refit(std::vector<SceneObject*>& sceneObjects);
+
+	bool closestHit(glm::vec3 p0, glm::vec3 dir, int& index, float& dist) const;
+
+	Occlusion occlusion(glm::vec3 p0, glm::vec3 dir, float maxDist, std::vector<int>* occluders = nullptr) const;
+
+	AABB getBounds() const;
+
+	glm::vec3 normal(int index, glm::vec3 p) const;
+
+	glm::vec2 texcoord(int index, glm::vec3 p) const;
+
+	float exit(int index, glm::vec3 p0, glm::vec3 dir, glm::vec3& normalVec) const;
+
+	const Material& getMaterial(int index) const;
+
+	int getNumObjects() const;
+
+	const BVH& getBVH() const;
+
+	const PrimTable& getTable(int type) const;
+
+	const std::vector<LeafRange>& getLeaves() const;
+
+	const std::vector<SceneObject*>& getObjects() const;
+};
+
+#endif //!H_COMPILEDSCENE
@@ -44,3 +44,59 @@ glm::vec3 Cone::normal(glm::vec3 p)
     n = glm::normalize(n);
     return n;
 }
+
+AABB Cone::bounds()
+{
+    return AABB(glm::vec3(center.x - radius, center.y, center.z - radius),
+        glm::vec3(center.x + radius, center.y + height, center.z + radius));
+}
+
+//Cylindrical texture coordinates: angle around the axis (u) and height above the base (v), in [0, 1]
+glm::vec2 Cone::texcoord(glm::vec3 p)
+{
+    float u = 0.5 + atan2(p.x - center.x, p.z - center.z) / (2 * 3.14159);
+    float v = (p.y - center.y) / height;
+    return glm::vec2(u, v);
+}
+
+/**
+* Exit of a ray starting inside the cone: the nearest root ahead that lies on the
+* cone itself rather than on its mirror image above the apex, unless the ray
+* reaches the base, which closes the solid, before that.
+*/
+float Cone::exit(glm::vec3 p0, glm::vec3 dir, glm::vec3& normalVec)
+{
+    float rh = (radius / height) * (radius / height);
+    float a = dir.x * dir.x + dir.z * dir.z - rh * dir.y * dir.y;
+    float b = 2 * (dir.x * (p0.x - center.x) + dir.z * (p0.z - center.z) + rh * dir.y * (height - p0.y + center.y));
+    float c = (center.x - p0.x) * (center.x - p0.x) + (center.z - p0.z) * (center.z - p0.z) -
+        rh * (height - p0.y + center.y) * (height - p0.y + center.y);
+    float t = 1.e+30f;
+    float delta = b * b - (4 * a * c);
+    if (fabs(a) > 1.e-8 && delta >= 0)
+    {
+        float roots[2] = { (-b - sqrt(delta)) / (2 * a), (-b + sqrt(delta)) / (2 * a) };
+        for (int k = 0; k < 2; k++)
+        {
+            float y = p0.y + roots[k] * dir.y;
+            if (roots[k] >= 0.001 && roots[k] < t && y <= center.y + height) t = roots[k];
+        }
+        if (t < 1.e+30f)
+        {
+            glm::vec3 p = p0 + t * dir;
+            float dx = p.x - center.x, dz = p.z - center.z;
+            float rho = sqrt(dx * dx + dz * dz);
+            normalVec = glm::normalize(glm::vec3(dx, rho * radius / height, dz));
+        }
+    }
+    if (dir.y < 0)
+    {
+        float tbase = (center.y - p0.y) / dir.y;
+        if (tbase < t)
+        {
+            t = tbase;
+            normalVec = glm::vec3(0, -1, 0);
+        }
+    }
+    return (t < 0.001 || t == 1.e+30f) ? -1 : t;
+}
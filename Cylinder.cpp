@@ -28,7 +28,12 @@ float Cylinder::intersect(glm::vec3 p0, glm::vec3 dir)
     {
         glm::vec3 second_intersect_point = p0 + p2 * dir;
         if (second_intersect_point.y > center.y + height || second_intersect_point.y < center.y) return -1.0;
-        else return (center.y + height - p0.y) / dir.y; //cap
+        //cap: only a hit if the ray crosses the top plane inside the rim, in front of the ray origin
+        float tcap = (center.y + height - p0.y) / dir.y;
+        glm::vec3 cap_point = p0 + tcap * dir;
+        float dx = cap_point.x - center.x, dz = cap_point.z - center.z;
+        if (tcap < 0.001 || dx * dx + dz * dz > radius * radius) return -1.0;
+        return tcap;
     }
     return p1;
 }
@@ -41,3 +46,47 @@ glm::vec3 Cylinder::normal(glm::vec3 p)
     n = glm::normalize(n);
     return n;
 }
+
+AABB Cylinder::bounds()
+{
+    return AABB(glm::vec3(center.x - radius, center.y, center.z - radius),
+        glm::vec3(center.x + radius, center.y + height, center.z + radius));
+}
+
+//Cylindrical texture coordinates: angle around the axis (u) and height above the base (v), in [0, 1]
+glm::vec2 Cylinder::texcoord(glm::vec3 p)
+{
+    float u = 0.5 + atan2(p.x - center.x, p.z - center.z) / (2 * 3.14159);
+    float v = (p.y - center.y) / height;
+    return glm::vec2(u, v);
+}
+
+/**
+* Exit of a ray starting inside the cylinder: the far root on the side, unless
+* the ray reaches the top (or the base, which closes the solid) before that.
+*/
+float Cylinder::exit(glm::vec3 p0, glm::vec3 dir, glm::vec3& normalVec)
+{
+    float t = 1.e+30f;
+    float a = dir.x * dir.x + dir.z * dir.z;
+    if (a > 1.e-8)
+    {
+        float b = 2 * (dir.x * (p0.x - center.x) + dir.z * (p0.z - center.z));
+        float c = (p0.x - center.x) * (p0.x - center.x) + (p0.z - center.z) * (p0.z - center.z) - radius * radius;
+        float delta = b * b - (4 * a * c);
+        if (delta < 0) delta = 0;
+        t = (-b + sqrt(delta)) / (2 * a);
+        glm::vec3 p = p0 + t * dir;
+        normalVec = glm::vec3(p.x - center.x, 0, p.z - center.z) / radius;
+    }
+    if (dir.y != 0)
+    {
+        float tcap = (dir.y > 0) ? (center.y + height - p0.y) / dir.y : (center.y - p0.y) / dir.y;
+        if (tcap < t)
+        {
+            t = tcap;
+            normalVec = glm::vec3(0, (dir.y > 0) ? 1 : -1, 0);
+        }
+    }
+    return (t < 0.001 || t == 1.e+30f) ? -1 : t;
+}
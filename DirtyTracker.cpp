@@ -0,0 +1,199 @@
+/*----------------------------------------------------------
+* COSC363  Ray Tracer
+*
+*  The dirty tracker class
+*  See DirtyTracker.h. The tests are conservative: a pixel
+*  may be marked that the change turns out not to affect,
+*  but never the other way round.
+-------------------------------------------------------------*/
+
+#include "DirtyTracker.h"
+#include <algorithm>
+
+//Whether an object within box could now block some of the shadow rays from the hits to the
+//light. The rays lie in a capsule around the segment from the hits' centre to the light's.
+static bool mayShadow(const AABB& hits, const Light& light, const AABB& box, float farDist)
+{
+	if (hits.max.x < hits.min.x) return false;		//No hits
+	glm::vec3 h = hits.centroid();
+	float r = 0.5f * glm::length(hits.max - hits.min);
+	glm::vec3 l = light.position;
+	if (light.type == LIGHT_DIRECTIONAL) l = h - farDist * light.direction;
+	else if (light.type == LIGHT_SPHERE) r += light.radius;
+	else if (light.type == LIGHT_RECT) r += 0.5f * (glm::length(light.edgeU) + glm::length(light.edgeV));
+
+	glm::vec3 b = box.centroid();
+	float rb = 0.5f * glm::length(box.max - box.min);
+	glm::vec3 d = l - h;
+	float dd = glm::dot(d, d);
+	float t = (dd > 0) ? glm::clamp(glm::dot(b - h, d) / dd, 0.0f, 1.0f) : 0;
+	return glm::length(b - (h + t * d)) <= r + rb;
+}
+
+//Starts afresh for a width x height framebuffer, all of it dirty. Call before a full render.
+void DirtyTracker::reset(int width, int height, int tileSize, const AABB& sceneBox)
+{
+	width_ = width;
+	height_ = height;
+	tileSize_ = tileSize;
+	tilesX_ = (width + tileSize - 1) / tileSize;
+	sceneBox_ = sceneBox;
+	tiles_.assign(tilesX_ * ((height + tileSize - 1) / tileSize), TileRecord());
+	pathBounds_.assign(width * height, AABB());
+	hitBounds_.assign(width * height, AABB());
+	dirty_.assign(width * height, 0);
+	numDirty_ = 0;
+	allDirty_ = true;
+}
+
+//Forgets the records of the tile's pixels (only its dirty ones if onlyDirty), before they are traced again
+void DirtyTracker::clearPixels(const Tile& tile, bool onlyDirty)
+{
+	TileRecord& rec = tiles_[tileIndex(tile.x0, tile.y0)];
+	auto stale = [&](int pixel) { return !onlyDirty || isDirty(pixel % width_, pixel / width_); };
+	rec.touched.erase(std::remove_if(rec.touched.begin(), rec.touched.end(),
+		[&](const std::pair<int, int>& e) { return stale(e.first); }), rec.touched.end());
+	for (int y = tile.y0; y < tile.y1; y++)
+		for (int x = tile.x0; x < tile.x1; x++)
+		{
+			int pixel = y * width_ + x;
+			if (!stale(pixel)) continue;
+			pathBounds_[pixel] = AABB();
+			hitBounds_[pixel] = AABB();
+		}
+}
+
+/**
+* Adds what a trace of the tile's pixels touched. pixelOf maps the record's pixels to
+* framebuffer pixels, which must lie in the tile. Tiles are independent, so different
+* tiles may be added from different threads.
+*/
+void DirtyTracker::add(const Tile& tile, const PixelRecord& record, const std::vector<int>& pixelOf)
+{
+	TileRecord& rec = tiles_[tileIndex(tile.x0, tile.y0)];
+	for (size_t i = 0; i < record.touched.size(); i++)
+		rec.touched.push_back(std::make_pair(pixelOf[record.touched[i].first], record.touched[i].second));
+	std::sort(rec.touched.begin(), rec.touched.end());
+	rec.touched.erase(std::unique(rec.touched.begin(), rec.touched.end()), rec.touched.end());
+
+	for (size_t i = 0; i < record.pathBounds.size(); i++)
+	{
+		pathBounds_[pixelOf[i]].expand(record.pathBounds[i]);
+		hitBounds_[pixelOf[i]].expand(record.hitBounds[i]);
+	}
+	rec.pathBounds = AABB();
+	rec.hitBounds = AABB();
+	for (int y = tile.y0; y < tile.y1; y++)
+		for (int x = tile.x0; x < tile.x1; x++)
+		{
+			rec.pathBounds.expand(pathBounds_[y * width_ + x]);
+			rec.hitBounds.expand(hitBounds_[y * width_ + x]);
+		}
+}
+
+void DirtyTracker::markPixel(int pixel)
+{
+	if (dirty_[pixel]) return;
+	dirty_[pixel] = 1;
+	numDirty_++;
+}
+
+/**
+* Marks the pixels an edit of objects (e.g. a frame of an animation) can affect: those
+* whose rays hit one or were shadowed by one where it was, those whose view, reflected
+* or refracted rays pass through where one is now, and those whose shadow rays might.
+* newBoxes are their bounds after the edit: where they were is covered by the pixels
+* whose rays met them.
+*/
+void DirtyTracker::objectsChanged(const std::vector<int>& objects, const std::vector<AABB>& newBoxes, const std::vector<Light>& lights)
+{
+	if (allDirty_ || objects.empty()) return;
+	AABB all;
+	std::vector<int> changed;		//By object: whether it is one of those edited
+	for (size_t k = 0; k < objects.size(); k++)
+	{
+		//Rays that left the scene were only recorded as far as its box
+		if (!sceneBox_.contains(newBoxes[k].min) || !sceneBox_.contains(newBoxes[k].max))
+		{
+			allDirty_ = true;
+			return;
+		}
+		all.expand(newBoxes[k]);
+		if (objects[k] >= (int)changed.size()) changed.resize(objects[k] + 1, 0);
+		changed[objects[k]] = 1;
+	}
+	auto overlapsAny = [&](const AABB& box)
+	{
+		if (!box.overlaps(all)) return false;
+		for (size_t k = 0; k < newBoxes.size(); k++)
+			if (box.overlaps(newBoxes[k])) return true;
+		return false;
+	};
+	float farDist = 2 * glm::length(sceneBox_.max - sceneBox_.min);
+	auto mayShadowAny = [&](const AABB& hits, const Light& light)
+	{
+		if (!mayShadow(hits, light, all, farDist)) return false;
+		for (size_t k = 0; k < newBoxes.size(); k++)
+			if (mayShadow(hits, light, newBoxes[k], farDist)) return true;
+		return false;
+	};
+
+	for (size_t t = 0; t < tiles_.size(); t++)
+	{
+		const TileRecord& rec = tiles_[t];
+		for (size_t i = 0; i < rec.touched.size(); i++)
+		{
+			int pixel = rec.touched[i].first, id = rec.touched[i].second;
+			if ((id >= 0 && id < (int)changed.size() && changed[id]) || (id < 0 && mayShadowAny(hitBounds_[pixel], lights[-1 - id]))) markPixel(pixel);
+		}
+		if (!overlapsAny(rec.pathBounds)) continue;
+		int x0 = (t % tilesX_) * tileSize_, y0 = (t / tilesX_) * tileSize_;
+		for (int y = y0; y < std::min(y0 + tileSize_, height_); y++)
+			for (int x = x0; x < std::min(x0 + tileSize_, width_); x++)
+				if (overlapsAny(pathBounds_[y * width_ + x])) markPixel(y * width_ + x);
+	}
+}
+
+/**
+* Marks the pixels an edit of a light can affect: those it reached before, and those
+* it may reach now. A light without a range may reach anything.
+*/
+void DirtyTracker::lightChanged(int light, const Light& newLight)
+{
+	if (allDirty_) return;
+	if (newLight.type == LIGHT_DIRECTIONAL || newLight.range <= 0)
+	{
+		allDirty_ = true;
+		return;
+	}
+	AABB reach(newLight.position - glm::vec3(newLight.range), newLight.position + glm::vec3(newLight.range));
+	for (size_t t = 0; t < tiles_.size(); t++)
+	{
+		const TileRecord& rec = tiles_[t];
+		for (size_t i = 0; i < rec.touched.size(); i++)
+			if (rec.touched[i].second == -1 - light) markPixel(rec.touched[i].first);
+		if (!rec.hitBounds.overlaps(reach)) continue;
+		int x0 = (t % tilesX_) * tileSize_, y0 = (t / tilesX_) * tileSize_;
+		for (int y = y0; y < std::min(y0 + tileSize_, height_); y++)
+			for (int x = x0; x < std::min(x0 + tileSize_, width_); x++)
+				if (hitBounds_[y * width_ + x].overlaps(reach)) markPixel(y * width_ + x);
+	}
+}
+
+//Call once the dirty pixels have been traced again
+void DirtyTracker::clearDirty()
+{
+	std::fill(dirty_.begin(), dirty_.end(), 0);
+	numDirty_ = 0;
+	allDirty_ = false;
+}
+
+//Whether any pixel of the tile, or within 'border' pixels of it, is dirty
+bool DirtyTracker::isTileDirty(const Tile& tile, int border) const
+{
+	if (allDirty_) return true;
+	for (int y = std::max(tile.y0 - border, 0); y < std::min(tile.y1 + border, height_); y++)
+		for (int x = std::max(tile.x0 - border, 0); x < std::min(tile.x1 + border, width_); x++)
+			if (dirty_[y * width_ + x]) return true;
+	return false;
+}
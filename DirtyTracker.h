@@ -0,0 +1,74 @@
+/*----------------------------------------------------------
+* COSC363  Ray Tracer
+*
+*  The dirty tracker class
+*  Keeps, for every pixel of the framebuffer, a record of
+*  what its rays touched: the objects they hit or that
+*  shadowed their hits, the lights that reached those hits,
+*  a box around its view, reflected and refracted rays and
+*  a box around its hit points. Tiles keep the union of
+*  their pixels' records. When an object or light changes,
+*  the records tell which pixels the change can affect, so
+*  that only those are traced again.
+-------------------------------------------------------------*/
+
+#ifndef H_DIRTYTRACKER
+#define H_DIRTYTRACKER
+
+#include <glm/glm.hpp>
+#include <vector>
+#include <utility>
+#include "AABB.h"
+#include "Light.h"
+#include "TileRenderer.h"
+#include "Wavefront.h"
+
+class DirtyTracker
+{
+private:
+	struct TileRecord
+	{
+		std::vector<std::pair<int, int>> touched;	//(pixel, object or -1 - light), sorted, no duplicates
+		AABB pathBounds;
+		AABB hitBounds;
+	};
+	int width_ = 0, height_ = 0;
+	int tileSize_ = 1, tilesX_ = 0;
+	AABB sceneBox_;							//Rays leaving the scene were recorded up to this box
+	std::vector<TileRecord> tiles_;
+	std::vector<AABB> pathBounds_;			//By pixel
+	std::vector<AABB> hitBounds_;
+	std::vector<unsigned char> dirty_;		//By pixel
+	int numDirty_ = 0;
+	bool allDirty_ = true;
+
+	int tileIndex(int x, int y) const { return (y / tileSize_) * tilesX_ + x / tileSize_; }
+	void markPixel(int pixel);
+
+public:
+	void reset(int width, int height, int tileSize, const AABB& sceneBox);
+
+	void clearPixels(const Tile& tile, bool onlyDirty);
+
+	void add(const Tile& tile, const PixelRecord& record, const std::vector<int>& pixelOf);
+
+	void objectsChanged(const std::vector<int>& objects, const std::vector<AABB>& newBoxes, const std::vector<Light>& lights);
+
+	void lightChanged(int light, const Light& newLight);
+
+	void markAll() { allDirty_ = true; }
+
+	void clearDirty();
+
+	bool isAllDirty() const { return allDirty_; }
+
+	bool isDirty(int x, int y) const { return allDirty_ || dirty_[y * width_ + x] != 0; }
+
+	bool isTileDirty(const Tile& tile, int border) const;
+
+	const AABB& getSceneBox() const { return sceneBox_; }
+
+	int getNumDirty() const { return allDirty_ ? width_ * height_ : numDirty_; }
+};
+
+#endif //!H_DIRTYTRACKER
@@ -0,0 +1,218 @@
+/*----------------------------------------------------------
+* COSC363  Ray Tracer
+*
+*  Image writer
+*  PNG files are written with uncompressed (stored) deflate
+*  blocks, which every PNG reader accepts and which need no
+*  zlib.
+-------------------------------------------------------------*/
+
+#include "ImageWriter.h"
+#include <iostream>
+#include <fstream>
+#include <cstring>
+#include <cstdint>
+#include <cctype>
+
+//8-bit value of a colour channel
+static unsigned char toByte(float v)
+{
+	if (v < 0) v = 0;
+	if (v > 1) v = 1;
+	return (unsigned char)(v * 255 + 0.5f);
+}
+
+static void put16(std::ofstream& file, uint16_t v)
+{
+	unsigned char b[2] = { (unsigned char)v, (unsigned char)(v >> 8) };
+	file.write((const char*)b, 2);
+}
+
+static void put32(std::ofstream& file, uint32_t v)
+{
+	unsigned char b[4] = { (unsigned char)v, (unsigned char)(v >> 8), (unsigned char)(v >> 16), (unsigned char)(v >> 24) };
+	file.write((const char*)b, 4);
+}
+
+static void put32BigEndian(std::vector<unsigned char>& out, uint32_t v)
+{
+	out.push_back(v >> 24);
+	out.push_back(v >> 16);
+	out.push_back(v >> 8);
+	out.push_back(v);
+}
+
+//Binary PPM (P6), top row first
+static void writePPM(std::ofstream& file, int width, int height, const std::vector<glm::vec3>& pixels)
+{
+	file << "P6\n" << width << " " << height << "\n255\n";
+	std::vector<unsigned char> row(3 * width);
+	for (int j = height - 1; j >= 0; j--)
+	{
+		for (int i = 0; i < width; i++)
+		{
+			glm::vec3 col = pixels[j*width + i];
+			row[3*i] = toByte(col.r);
+			row[3*i + 1] = toByte(col.g);
+			row[3*i + 2] = toByte(col.b);
+		}
+		file.write((const char*)&row[0], row.size());
+	}
+}
+
+//Portable float map (PF), bottom row first like the framebuffer
+static void writePFM(std::ofstream& file, int width, int height, const std::vector<glm::vec3>& pixels)
+{
+	file << "PF\n" << width << " " << height << "\n-1.0\n";	//Negative scale: little-endian floats
+	file.write((const char*)&pixels[0], sizeof(glm::vec3) * width * height);
+}
+
+//24-bit uncompressed Windows BMP, bottom row first, rows padded to 4 bytes
+static void writeBMP(std::ofstream& file, int width, int height, const std::vector<glm::vec3>& pixels)
+{
+	int rowSize = (3 * width + 3) & ~3;
+	int dataSize = rowSize * height;
+	file.write("BM", 2);
+	put32(file, 54 + dataSize);		//File size
+	put32(file, 0);
+	put32(file, 54);				//Offset of the pixel data
+	put32(file, 40);				//BITMAPINFOHEADER
+	put32(file, width);
+	put32(file, height);
+	put16(file, 1);					//Planes
+	put16(file, 24);				//Bits per pixel
+	put32(file, 0);					//No compression
+	put32(file, dataSize);
+	put32(file, 2835);				//72 dpi
+	put32(file, 2835);
+	put32(file, 0);
+	put32(file, 0);
+
+	std::vector<unsigned char> row(rowSize, 0);
+	for (int j = 0; j < height; j++)
+	{
+		for (int i = 0; i < width; i++)
+		{
+			glm::vec3 col = pixels[j*width + i];
+			row[3*i] = toByte(col.b);
+			row[3*i + 1] = toByte(col.g);
+			row[3*i + 2] = toByte(col.r);
+		}
+		file.write((const char*)&row[0], rowSize);
+	}
+}
+
+static uint32_t crc32(const unsigned char* data, size_t length, uint32_t crc = 0)
+{
+	static uint32_t table[256];
+	static bool init = false;
+	if (!init)
+	{
+		for (uint32_t n = 0; n < 256; n++)
+		{
+			uint32_t c = n;
+			for (int k = 0; k < 8; k++) c = (c & 1) ? 0xedb88320u ^ (c >> 1) : c >> 1;
+			table[n] = c;
+		}
+		init = true;
+	}
+	crc = ~crc;
+	for (size_t i = 0; i < length; i++) crc = table[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+	return ~crc;
+}
+
+//Writes one PNG chunk: length, type, data, CRC of type and data
+static void writeChunk(std::ofstream& file, const char* type, const std::vector<unsigned char>& data)
+{
+	std::vector<unsigned char> chunk;
+	put32BigEndian(chunk, data.size());
+	chunk.insert(chunk.end(), type, type + 4);
+	chunk.insert(chunk.end(), data.begin(), data.end());
+	put32BigEndian(chunk, crc32(&chunk[4], chunk.size() - 4));
+	file.write((const char*)&chunk[0], chunk.size());
+}
+
+//8-bit RGB PNG, top row first, as a zlib stream of stored blocks
+static void writePNG(std::ofstream& file, int width, int height, const std::vector<glm::vec3>& pixels)
+{
+	static const unsigned char signature[8] = { 137, 'P', 'N', 'G', '\r', '\n', 26, '\n' };
+	file.write((const char*)signature, 8);
+
+	std::vector<unsigned char> header;
+	put32BigEndian(header, width);
+	put32BigEndian(header, height);
+	unsigned char rest[5] = { 8, 2, 0, 0, 0 };		//8 bits, RGB, deflate, no filter, no interlace
+	header.insert(header.end(), rest, rest + 5);
+	writeChunk(file, "IHDR", header);
+
+	//Raw scanlines, each preceded by filter type 0
+	std::vector<unsigned char> raw;
+	raw.reserve((3 * width + 1) * height);
+	for (int j = height - 1; j >= 0; j--)
+	{
+		raw.push_back(0);
+		for (int i = 0; i < width; i++)
+		{
+			glm::vec3 col = pixels[j*width + i];
+			raw.push_back(toByte(col.r));
+			raw.push_back(toByte(col.g));
+			raw.push_back(toByte(col.b));
+		}
+	}
+
+	std::vector<unsigned char> z;
+	z.push_back(0x78);		//zlib header: deflate, 32K window, no preset dictionary
+	z.push_back(0x01);
+	uint32_t a = 1, b = 0;	//Adler-32
+	size_t pos = 0;
+	bool last = false;
+	while (!last)
+	{
+		size_t len = raw.size() - pos;
+		if (len > 65535) len = 65535;
+		last = (pos + len == raw.size());
+		z.push_back(last ? 1 : 0);
+		z.push_back(len & 0xff);
+		z.push_back(len >> 8);
+		z.push_back(~len & 0xff);
+		z.push_back((~len >> 8) & 0xff);
+		for (size_t i = pos; i < pos + len; i++)
+		{
+			z.push_back(raw[i]);
+			a = (a + raw[i]) % 65521;
+			b = (b + a) % 65521;
+		}
+		pos += len;
+	}
+	put32BigEndian(z, (b << 16) | a);
+	writeChunk(file, "IDAT", z);
+	writeChunk(file, "IEND", std::vector<unsigned char>());
+}
+
+static bool hasExtension(const char* filename, const char* ext)
+{
+	size_t n = strlen(filename), m = strlen(ext);
+	if (n < m) return false;
+	for (size_t i = 0; i < m; i++)
+	{
+		if (tolower((unsigned char)filename[n - m + i]) != ext[i]) return false;
+	}
+	return true;
+}
+
+bool writeImage(const char* filename, int width, int height, const std::vector<glm::vec3>& pixels)
+{
+	if (width <= 0 || height <= 0 || pixels.size() < (size_t)width * height) return false;
+	std::ofstream file(filename, std::ios::out | std::ios::binary);
+	if (!file)
+	{
+		std::cout << "*** Error creating image file: " << filename << std::endl;
+		return false;
+	}
+
+	if (hasExtension(filename, ".png")) writePNG(file, width, height, pixels);
+	else if (hasExtension(filename, ".bmp")) writeBMP(file, width, height, pixels);
+	else if (hasExtension(filename, ".pfm")) writePFM(file, width, height, pixels);
+	else writePPM(file, width, height, pixels);
+	return (bool)file;
+}
@@ -0,0 +1,24 @@
+/*----------------------------------------------------------
+* COSC363  Ray Tracer
+*
+*  Image writer
+*  Saves a rendered framebuffer as PPM, PNG, BMP or PFM,
+*  chosen by the file extension. Needs no external library
+*  and no OpenGL context, so it also works on headless
+*  render nodes.
+-------------------------------------------------------------*/
+
+#ifndef H_IMAGEWRITER
+#define H_IMAGEWRITER
+
+#include <glm/glm.hpp>
+#include <vector>
+
+/**
+* Writes width x height pixels, stored row by row starting with the bottom row
+* (the layout of the ray tracer's framebuffer). PPM, PNG and BMP are written
+* with 8 bits per channel, clamped to [0, 1]; PFM keeps the unclamped floats.
+*/
+bool writeImage(const char* filename, int width, int height, const std::vector<glm::vec3>& pixels);
+
+#endif //!H_IMAGEWRITER
@@ -0,0 +1,89 @@
+/*----------------------------------------------------------
+* COSC363  Ray Tracer
+*
+*  The instance class
+*  See Instance.h.
+-------------------------------------------------------------*/
+
+#include "Instance.h"
+#include <cmath>
+
+//Places 'prototype', which must outlive the instance, with the affine transform toWorld
+Instance::Instance(SceneObject* prototype, const glm::mat4& toWorld)
+	: prototype_(prototype)
+{
+	setTransform(toWorld);
+}
+
+//Moves the instance. The scene must be compiled again (or refitted) afterwards.
+void Instance::setTransform(const glm::mat4& toWorld)
+{
+	toWorld_ = toWorld;
+	toObject_ = glm::inverse(toWorld);
+	normalToWorld_ = glm::transpose(glm::mat3(toObject_));
+}
+
+//Rotation by 'degrees' about 'axis' through the origin (Rodrigues' formula); the identity for a zero axis
+glm::mat4 Instance::rotation(float degrees, glm::vec3 axis)
+{
+	glm::mat4 m(1);
+	if (glm::length(axis) == 0) return m;
+	glm::vec3 a = glm::normalize(axis);
+	float angle = degrees * (3.14159265 / 180), c = cos(angle), s = sin(angle);
+	for (int col = 0; col < 3; col++)
+		for (int row = 0; row < 3; row++)
+		{
+			float cross = 0;
+			if (col == 0) cross = (row == 1) ? a.z : (row == 2) ? -a.y : 0;
+			if (col == 1) cross = (row == 0) ? -a.z : (row == 2) ? a.x : 0;
+			if (col == 2) cross = (row == 0) ? a.y : (row == 1) ? -a.x : 0;
+			m[col][row] = (row == col ? c : 0) + (1 - c) * a[row] * a[col] + s * cross;
+		}
+	return m;
+}
+
+/**
+* Intersects the ray in the prototype's space. The prototypes expect a unit direction,
+* so the transformed direction is normalised and the distance scaled back by its length.
+*/
+float Instance::intersect(glm::vec3 p0, glm::vec3 dir)
+{
+	glm::vec3 d = glm::vec3(toObject_ * glm::vec4(dir, 0));
+	float len = glm::length(d);
+	float t = prototype_->intersect(objectPoint(p0), d / len);
+	return (t > 0) ? t / len : t;
+}
+
+glm::vec3 Instance::normal(glm::vec3 p)
+{
+	return glm::normalize(normalToWorld_ * prototype_->normal(objectPoint(p)));
+}
+
+//The prototype's box, transformed: the box around its 8 transformed corners
+AABB Instance::bounds()
+{
+	AABB box = prototype_->bounds();
+	AABB result;
+	for (int k = 0; k < 8; k++)
+	{
+		glm::vec3 corner((k & 1) ? box.max.x : box.min.x, (k & 2) ? box.max.y : box.min.y, (k & 4) ? box.max.z : box.min.z);
+		result.expand(glm::vec3(toWorld_ * glm::vec4(corner, 1)));
+	}
+	return result;
+}
+
+//The prototype's UVs, so a texture moves with the instance
+glm::vec2 Instance::texcoord(glm::vec3 p)
+{
+	return prototype_->texcoord(objectPoint(p));
+}
+
+float Instance::exit(glm::vec3 p0, glm::vec3 dir, glm::vec3& normalVec)
+{
+	glm::vec3 d = glm::vec3(toObject_ * glm::vec4(dir, 0));
+	float len = glm::length(d);
+	float t = prototype_->exit(objectPoint(p0), d / len, normalVec);
+	if (t <= 0) return t;
+	normalVec = glm::normalize(normalToWorld_ * normalVec);
+	return t / len;
+}
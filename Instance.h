@@ -0,0 +1,57 @@
+/*----------------------------------------------------------
+* COSC363  Ray Tracer
+*
+*  The instance class
+*  This is a subclass of Object, and hence implements the
+*  methods intersect() and normal().
+*  An instance places a shared prototype object (a primitive
+*  or a mesh, with its own BVH) in the scene through an
+*  affine transform. Rays are taken into the prototype's
+*  space rather than the geometry into the scene's, so any
+*  number of copies share one prototype and cost a transform
+*  each. The scene BVH is built over the instances: a two
+*  level structure whose lower level is the prototype's.
+*  Transforms also free cylinders and cones from the y axis.
+-------------------------------------------------------------*/
+
+#ifndef H_INSTANCE
+#define H_INSTANCE
+
+#include <glm/glm.hpp>
+#include "SceneObject.h"
+
+class Instance : public SceneObject
+{
+private:
+	SceneObject* prototype_ = nullptr;
+	glm::mat4 toWorld_ = glm::mat4(1);
+	glm::mat4 toObject_ = glm::mat4(1);			//Inverse of toWorld_
+	glm::mat3 normalToWorld_ = glm::mat3(1);	//Inverse transpose of toWorld_'s linear part
+
+	glm::vec3 objectPoint(glm::vec3 p) const { return glm::vec3(toObject_ * glm::vec4(p, 1)); }
+
+public:
+	Instance() {}
+
+	Instance(SceneObject* prototype, const glm::mat4& toWorld);
+
+	float intersect(glm::vec3 p0, glm::vec3 dir);
+
+	glm::vec3 normal(glm::vec3 p);
+
+	AABB bounds();
+
+	glm::vec2 texcoord(glm::vec3 p);
+
+	float exit(glm::vec3 p0, glm::vec3 dir, glm::vec3& normalVec);
+
+	SceneObject* getPrototype() { return prototype_; }
+
+	const glm::mat4& getTransform() { return toWorld_; }
+
+	void setTransform(const glm::mat4& toWorld);
+
+	static glm::mat4 rotation(float degrees, glm::vec3 axis);
+};
+
+#endif //!H_INSTANCE
@@ -0,0 +1,66 @@
+/*----------------------------------------------------------
+* COSC363  Ray Tracer
+*
+*  The light class
+*  See Light.h.
+-------------------------------------------------------------*/
+
+#include "Light.h"
+#include <cmath>
+
+/**
+* Whether the light can reach point p at all: p is within its range, inside a spot
+* light's cone and in front of a rectangle light. These tests are cheap, so they come before any
+* shadow ray is cast. If so, returns the unit vector towards the light, the
+* distance a shadow ray must clear, and the fall-off of the light's intensity.
+*/
+bool Light::illuminates(glm::vec3 p, glm::vec3& lightVec, float& dist, float& attenuation) const
+{
+	attenuation = 1;
+	if (type == LIGHT_DIRECTIONAL)
+	{
+		lightVec = -direction;
+		dist = 1.e+30f;
+		return true;
+	}
+
+	glm::vec3 toLight = position - p;
+	float dist2 = glm::dot(toLight, toLight);
+	if (range > 0)
+	{
+		float x = dist2 / (range * range);
+		if (x >= 1) return false;
+		attenuation = (1 - x) * (1 - x);
+	}
+	dist = sqrt(dist2);
+	lightVec = toLight / dist;
+	if (type == LIGHT_SPOT && glm::dot(-lightVec, direction) < cosCutoff) return false;
+	if (type == LIGHT_RECT && glm::dot(lightVec, glm::cross(edgeU, edgeV)) >= 0) return false;
+	return true;
+}
+
+/**
+* A point on an area light, as seen from p, for (u, v) in [0, 1)^2. Evenly spread
+* (u, v) give evenly spread points: on a rectangle directly, and on a sphere over
+* the disc it presents to p, which is what p's view of the sphere is made of.
+*/
+glm::vec3 Light::samplePoint(glm::vec3 p, float u, float v) const
+{
+	if (type == LIGHT_RECT) return position + (u - 0.5f) * edgeU + (v - 0.5f) * edgeV;
+
+	glm::vec3 w = glm::normalize(position - p);
+	glm::vec3 a = glm::normalize(glm::cross(w, fabs(w.y) < 0.9 ? glm::vec3(0, 1, 0) : glm::vec3(1, 0, 0)));
+	glm::vec3 b = glm::cross(w, a);
+	float r = radius * sqrt(u), phi = 6.2831853f * v;
+	return position + r * (cos(phi) * a + sin(phi) * b);
+}
+
+//Whether the light's sphere of influence reaches the inside of the planes (normal xyz, offset w),
+//i.e. whether it can light anything there. Lights of unlimited range always can.
+bool Light::inFrustum(const glm::vec4* planes, int numPlanes) const
+{
+	if (type == LIGHT_DIRECTIONAL || range <= 0) return true;
+	for (int i = 0; i < numPlanes; i++)
+		if (glm::dot(glm::vec3(planes[i]), position) + planes[i].w < -range) return false;
+	return true;
+}
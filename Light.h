@@ -0,0 +1,53 @@
+/*----------------------------------------------------------
+* COSC363  Ray Tracer
+*
+*  The light class
+*  A point, spot or directional light, or an area light: a
+*  sphere or a rectangle. Area lights are shaded as a point
+*  light at their centre, but cast soft shadows: their
+*  visibility is estimated from shadow rays to points spread
+*  over the light. Lights other than directional ones may
+*  have a range, beyond which they light nothing: their
+*  intensity falls smoothly to zero there. This bounds every
+*  light's influence, so that lights can be culled against
+*  the parts of the scene a tile of the image can see.
+-------------------------------------------------------------*/
+
+#ifndef H_LIGHT
+#define H_LIGHT
+
+#include <glm/glm.hpp>
+#include <cstdint>
+
+enum LightType
+{
+	LIGHT_POINT = 0,
+	LIGHT_SPOT,
+	LIGHT_DIRECTIONAL,
+	LIGHT_SPHERE,
+	LIGHT_RECT				//One-sided: lights the side edgeU x edgeV points to
+};
+
+struct Light
+{
+	int32_t type = LIGHT_POINT;
+	glm::vec3 position = glm::vec3(0);		//All but directional lights; the centre of an area light
+	glm::vec3 direction = glm::vec3(0, -1, 0);	//Spot and directional lights: unit direction the light travels
+	glm::vec3 color = glm::vec3(1);
+	float cosCutoff = -1;					//Spot lights: cosine of the cone half-angle
+	float range = 0;						//All but directional lights: 0 for unlimited
+	float radius = 0;						//Sphere lights
+	glm::vec3 edgeU = glm::vec3(0);			//Rectangle lights: the two sides
+	glm::vec3 edgeV = glm::vec3(0);
+	int samples = 1;						//Area lights: most shadow rays per hit
+
+	bool isArea() const { return type == LIGHT_SPHERE || type == LIGHT_RECT; }
+
+	bool illuminates(glm::vec3 p, glm::vec3& lightVec, float& dist, float& attenuation) const;
+
+	glm::vec3 samplePoint(glm::vec3 p, float u, float v) const;
+
+	bool inFrustum(const glm::vec4* planes, int numPlanes) const;
+};
+
+#endif //!H_LIGHT
@@ -0,0 +1,88 @@
+/*----------------------------------------------------------
+* COSC363  Ray Tracer
+*
+*  The mapped file class
+*  Uses MapViewOfFile on Windows and mmap elsewhere.
+-------------------------------------------------------------*/
+
+#include "MappedFile.h"
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+MappedFile::~MappedFile()
+{
+	close();
+}
+
+//Maps the file; returns false (leaving the object closed) if it cannot be opened or is empty
+bool MappedFile::open(const char* filename)
+{
+	close();
+#if defined(_WIN32)
+	HANDLE file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file == INVALID_HANDLE_VALUE) return false;
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(file, &size) || size.QuadPart == 0)
+	{
+		CloseHandle(file);
+		return false;
+	}
+	HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (mapping == NULL)
+	{
+		CloseHandle(file);
+		return false;
+	}
+	void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	if (data == NULL)
+	{
+		CloseHandle(mapping);
+		CloseHandle(file);
+		return false;
+	}
+	file_ = file;
+	mapping_ = mapping;
+	data_ = (const char*)data;
+	size_ = (size_t)size.QuadPart;
+#else
+	int fd = ::open(filename, O_RDONLY);
+	if (fd < 0) return false;
+	struct stat st;
+	if (fstat(fd, &st) != 0 || st.st_size == 0)
+	{
+		::close(fd);
+		return false;
+	}
+	void* data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	::close(fd);		//The mapping keeps the file alive
+	if (data == MAP_FAILED) return false;
+	data_ = (const char*)data;
+	size_ = st.st_size;
+#endif
+	return true;
+}
+
+void MappedFile::close()
+{
+	if (data_ == nullptr) return;
+#if defined(_WIN32)
+	UnmapViewOfFile(data_);
+	CloseHandle(mapping_);
+	CloseHandle(file_);
+	file_ = nullptr;
+	mapping_ = nullptr;
+#else
+	munmap((void*)data_, size_);
+#endif
+	data_ = nullptr;
+	size_ = 0;
+}
@@ -0,0 +1,44 @@
+/*----------------------------------------------------------
+* COSC363  Ray Tracer
+*
+*  The mapped file class
+*  Maps a whole file read-only into memory, so that binary
+*  assets can be used in place without being read or parsed.
+*  Pages are loaded by the OS on first access.
+-------------------------------------------------------------*/
+
+#ifndef H_MAPPEDFILE
+#define H_MAPPEDFILE
+
+#include <cstddef>
+
+class MappedFile
+{
+private:
+	const char* data_ = nullptr;
+	size_t size_ = 0;
+#if defined(_WIN32)
+	void* file_ = nullptr;		//Windows file and mapping handles
+	void* mapping_ = nullptr;
+#endif
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+public:
+	MappedFile() {}
+
+	~MappedFile();
+
+	bool open(const char* filename);
+
+	void close();
+
+	const char* data() const { return data_; }
+
+	size_t size() const { return size_; }
+
+	bool isOpen() const { return data_ != nullptr; }
+};
+
+#endif //!H_MAPPEDFILE
@@ -0,0 +1,36 @@
+/*----------------------------------------------------------
+* COSC363  Ray Tracer
+*
+*  The material class
+*  Holds the surface properties of a scene object (colour,
+*  reflection, refraction, transparency and specular terms).
+-------------------------------------------------------------*/
+
+#include "Material.h"
+#include <math.h>
+
+const float AMBIENT = 0.2;		//Fraction of the surface colour seen without any light
+
+//The light every surface receives regardless of the lights: a fixed fraction of its colour
+glm::vec3 Material::ambient(glm::vec3 surfaceCol) const
+{
+	return AMBIENT * surfaceCol;
+}
+
+//Phong diffuse and specular terms of one light, given the unit normal at the hit point
+//and the unit vector towards the light. surfaceCol is the colour of the surface at the
+//hit point, which is the material colour unless a texture or procedural pattern
+//overrides it. The ambient term is separate, since it is added once, not per light.
+glm::vec3 Material::lighting(glm::vec3 normalVec, glm::vec3 lightVec, glm::vec3 lightCol, glm::vec3 viewVec, glm::vec3 surfaceCol) const
+{
+	float specularTerm = 0;
+	float lDotn = glm::dot(lightVec, normalVec);
+	if (lDotn <= 0) return glm::vec3(0);		//The light is behind the surface
+	if (spec)
+	{
+		glm::vec3 reflVec = glm::reflect(-lightVec, normalVec);
+		float rDotv = glm::dot(reflVec, viewVec);
+		if (rDotv > 0) specularTerm = pow(rDotv, shin);
+	}
+	return lightCol * (lDotn * surfaceCol + specularTerm * glm::vec3(1));
+}
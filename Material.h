@@ -0,0 +1,50 @@
+/*----------------------------------------------------------
+* COSC363  Ray Tracer
+*
+*  The material class
+*  Holds the surface properties of a scene object (colour,
+*  reflection, refraction, transparency and specular terms).
+*  The compiled scene keeps the materials in their own array,
+*  indexed by object, apart from the geometry.
+-------------------------------------------------------------*/
+
+#ifndef H_MATERIAL
+#define H_MATERIAL
+#include <glm/glm.hpp>
+#include <cstdint>
+#include "Texture.h"
+
+//How the surface colour varies over an object, evaluated at the UVs the object supplies
+enum MappingMode
+{
+	MAP_NONE = 0,		//Plain material colour
+	MAP_TEXTURE,		//Image texture
+	MAP_CHECKER,		//Procedural checkerboard of color and color2
+	NUM_MAPPINGS
+};
+
+struct Material
+{
+	glm::vec3 color = glm::vec3(1);		//material color
+	bool refl = false;					//reflectivity: true/false
+	bool refr = false;					//refractivity: true/false
+	bool spec = true;					//specularity: true/false
+	bool tran = false;					//transparency: true/false
+	bool reflfront = false;				//reflect only where the normal faces +z
+	float reflc = 0.8;					//coefficient of reflection
+	float refrc = 0.8;					//coefficient of refraction
+	float tranc = 0.8;					//coefficient of transparency
+	float refri = 1.0;					//refractive index
+	float shin = 50.0;					//shininess
+	int32_t mapping = MAP_NONE;			//see MappingMode
+	int32_t texture = -1;				//MAP_TEXTURE: index of the image in the scene's textures
+	int32_t filter = FILTER_TRILINEAR;	//MAP_TEXTURE: see TextureFilter
+	glm::vec3 color2 = glm::vec3(0);	//MAP_CHECKER: colour of the odd squares
+	float repeatU = 1;					//number of times the texture or checker repeats across
+	float repeatV = 1;					//the object's UV range
+
+	glm::vec3 ambient(glm::vec3 surfaceCol) const;
+	glm::vec3 lighting(glm::vec3 normalVec, glm::vec3 lightVec, glm::vec3 lightCol, glm::vec3 viewVec, glm::vec3 surfaceCol) const;
+};
+
+#endif //!H_MATERIAL
@@ -0,0 +1,74 @@
+/*----------------------------------------------------------
+* COSC363  Ray Tracer
+*
+*  8-wide packet kernels using AVX2
+*  Only called when the CPU reports AVX2 support, see
+*  PacketTracer::getMaxWidth().
+-------------------------------------------------------------*/
+
+#include "RayPacket.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#include <immintrin.h>
+
+#if defined(__clang__)
+#pragma clang attribute push (__attribute__((target("avx2"))), apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("avx2")
+#pragma GCC optimize("fp-contract=off")	//No fused multiply-adds: the results must match the scalar code
+#endif
+
+namespace PacketAVX2
+{
+	const int WIDTH = 8;
+
+	struct vfloat { __m256 v; };
+	struct vmask { __m256 m; };
+
+	static inline vfloat set1(float a) { vfloat r; r.v = _mm256_set1_ps(a); return r; }
+	static inline vfloat load(const float* p) { vfloat r; r.v = _mm256_load_ps(p); return r; }
+	static inline void store(float* p, vfloat a) { _mm256_store_ps(p, a.v); }
+
+	static inline vfloat operator+(vfloat a, vfloat b) { vfloat r; r.v = _mm256_add_ps(a.v, b.v); return r; }
+	static inline vfloat operator-(vfloat a, vfloat b) { vfloat r; r.v = _mm256_sub_ps(a.v, b.v); return r; }
+	static inline vfloat operator*(vfloat a, vfloat b) { vfloat r; r.v = _mm256_mul_ps(a.v, b.v); return r; }
+	static inline vfloat operator/(vfloat a, vfloat b) { vfloat r; r.v = _mm256_div_ps(a.v, b.v); return r; }
+	static inline vfloat vsqrt(vfloat a) { vfloat r; r.v = _mm256_sqrt_ps(a.v); return r; }
+	static inline vfloat vmin(vfloat a, vfloat b) { vfloat r; r.v = _mm256_min_ps(a.v, b.v); return r; }
+	static inline vfloat vmax(vfloat a, vfloat b) { vfloat r; r.v = _mm256_max_ps(a.v, b.v); return r; }
+	static inline vfloat vabs(vfloat a) { vfloat r; r.v = _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a.v); return r; }
+
+	static inline vmask operator<(vfloat a, vfloat b) { vmask r; r.m = _mm256_cmp_ps(a.v, b.v, _CMP_LT_OQ); return r; }
+	static inline vmask operator>(vfloat a, vfloat b) { vmask r; r.m = _mm256_cmp_ps(a.v, b.v, _CMP_GT_OQ); return r; }
+	static inline vmask operator<=(vfloat a, vfloat b) { vmask r; r.m = _mm256_cmp_ps(a.v, b.v, _CMP_LE_OQ); return r; }
+	static inline vmask operator>=(vfloat a, vfloat b) { vmask r; r.m = _mm256_cmp_ps(a.v, b.v, _CMP_GE_OQ); return r; }
+	static inline vmask operator==(vfloat a, vfloat b) { vmask r; r.m = _mm256_cmp_ps(a.v, b.v, _CMP_EQ_OQ); return r; }
+	static inline vmask operator&(vmask a, vmask b) { vmask r; r.m = _mm256_and_ps(a.m, b.m); return r; }
+	static inline vmask operator|(vmask a, vmask b) { vmask r; r.m = _mm256_or_ps(a.m, b.m); return r; }
+
+	static inline vfloat select(vmask m, vfloat a, vfloat b)	//m ? a : b
+	{
+		vfloat r; r.v = _mm256_blendv_ps(b.v, a.v, m.m); return r;
+	}
+	static inline bool any(vmask m) { return _mm256_movemask_ps(m.m) != 0; }
+	static inline vmask laneMask(int count)		//The first count lanes
+	{
+		vmask r; r.m = _mm256_cmp_ps(_mm256_setr_ps(0, 1, 2, 3, 4, 5, 6, 7), _mm256_set1_ps((float)count), _CMP_LT_OQ); return r;
+	}
+
+#include "PacketKernels.inl"
+}
+
+void closestPtAVX2(const PacketScene& scene, RayPacket& packet, int first, int count)
+{
+	PacketAVX2::closestPtPacket(scene, packet, first, count);
+}
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+
+#endif
@@ -0,0 +1,74 @@
+/*----------------------------------------------------------
+* COSC363  Ray Tracer
+*
+*  16-wide packet kernels using AVX-512F
+*  Only called when the CPU reports AVX-512F support, see
+*  PacketTracer::getMaxWidth().
+-------------------------------------------------------------*/
+
+#include "RayPacket.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#include <immintrin.h>
+
+#if defined(__clang__)
+#pragma clang attribute push (__attribute__((target("avx512f"))), apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("avx512f")
+#pragma GCC optimize("fp-contract=off")	//No fused multiply-adds: the results must match the scalar code
+#endif
+
+namespace PacketAVX512
+{
+	const int WIDTH = 16;
+
+	struct vfloat { __m512 v; };
+	struct vmask { __mmask16 m; };
+
+	static inline vfloat set1(float a) { vfloat r; r.v = _mm512_set1_ps(a); return r; }
+	static inline vfloat load(const float* p) { vfloat r; r.v = _mm512_load_ps(p); return r; }
+	static inline void store(float* p, vfloat a) { _mm512_store_ps(p, a.v); }
+
+	static inline vfloat operator+(vfloat a, vfloat b) { vfloat r; r.v = _mm512_add_ps(a.v, b.v); return r; }
+	static inline vfloat operator-(vfloat a, vfloat b) { vfloat r; r.v = _mm512_sub_ps(a.v, b.v); return r; }
+	static inline vfloat operator*(vfloat a, vfloat b) { vfloat r; r.v = _mm512_mul_ps(a.v, b.v); return r; }
+	static inline vfloat operator/(vfloat a, vfloat b) { vfloat r; r.v = _mm512_div_ps(a.v, b.v); return r; }
+	static inline vfloat vsqrt(vfloat a) { vfloat r; r.v = _mm512_sqrt_ps(a.v); return r; }
+	static inline vfloat vmin(vfloat a, vfloat b) { vfloat r; r.v = _mm512_min_ps(a.v, b.v); return r; }
+	static inline vfloat vmax(vfloat a, vfloat b) { vfloat r; r.v = _mm512_max_ps(a.v, b.v); return r; }
+	static inline vfloat vabs(vfloat a) { vfloat r; r.v = _mm512_abs_ps(a.v); return r; }
+
+	static inline vmask operator<(vfloat a, vfloat b) { vmask r; r.m = _mm512_cmp_ps_mask(a.v, b.v, _CMP_LT_OQ); return r; }
+	static inline vmask operator>(vfloat a, vfloat b) { vmask r; r.m = _mm512_cmp_ps_mask(a.v, b.v, _CMP_GT_OQ); return r; }
+	static inline vmask operator<=(vfloat a, vfloat b) { vmask r; r.m = _mm512_cmp_ps_mask(a.v, b.v, _CMP_LE_OQ); return r; }
+	static inline vmask operator>=(vfloat a, vfloat b) { vmask r; r.m = _mm512_cmp_ps_mask(a.v, b.v, _CMP_GE_OQ); return r; }
+	static inline vmask operator==(vfloat a, vfloat b) { vmask r; r.m = _mm512_cmp_ps_mask(a.v, b.v, _CMP_EQ_OQ); return r; }
+	static inline vmask operator&(vmask a, vmask b) { vmask r; r.m = a.m & b.m; return r; }
+	static inline vmask operator|(vmask a, vmask b) { vmask r; r.m = a.m | b.m; return r; }
+
+	static inline vfloat select(vmask m, vfloat a, vfloat b)	//m ? a : b
+	{
+		vfloat r; r.v = _mm512_mask_blend_ps(m.m, b.v, a.v); return r;
+	}
+	static inline bool any(vmask m) { return m.m != 0; }
+	static inline vmask laneMask(int count)		//The first count lanes
+	{
+		vmask r; r.m = (__mmask16)((count >= 16) ? 0xffff : (1u << count) - 1); return r;
+	}
+
+#include "PacketKernels.inl"
+}
+
+void closestPtAVX512(const PacketScene& scene, RayPacket& packet, int first, int count)
+{
+	PacketAVX512::closestPtPacket(scene, packet, first, count);
+}
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+
+#endif
@@ -0,0 +1,257 @@
+/*----------------------------------------------------------
+* COSC363  Ray Tracer
+*
+*  Packet intersection kernels
+*  Included by PacketSSE.cpp, PacketAVX2.cpp and PacketAVX512.cpp
+*  inside their own namespace, after each has defined
+*     WIDTH, vfloat, vmask, set1(), load(), store(), vsqrt(),
+*     vabs(), vmin(), vmax(), select(), any(), laneMask()
+*  and the arithmetic/comparison operators for its instruction set.
+*  The kernels reproduce the hit rules of the scalar
+*  intersect() methods lane by lane, evaluating the same
+*  expressions in the same order so that results agree
+*  to the last bit wherever possible.
+-------------------------------------------------------------*/
+
+struct PacketState
+{
+	vfloat ox, oy, oz;		//Origins
+	vfloat dx, dy, dz;		//Unit directions
+	vfloat ix, iy, iz;		//Inverse directions, for the box tests
+	vfloat tmin;			//Closest hit so far
+	vfloat index;			//Object of the closest hit so far (exact for fewer than 2^24 objects)
+	vmask active;			//Lanes that hold a ray
+};
+
+//Keeps the new hits that are closer than the current ones; ties go to the lower object index
+static inline void updateHits(PacketState& s, vmask hit, vfloat t, int object)
+{
+	vfloat obj = set1((float)object);
+	vmask closer = hit & ((t < s.tmin) | ((t == s.tmin) & (obj < s.index)));
+	s.tmin = select(closer, t, s.tmin);
+	s.index = select(closer, obj, s.index);
+}
+
+static inline vmask hitBox(const PacketState& s, const AABB& box)
+{
+	vfloat tx1 = (set1(box.min.x) - s.ox) * s.ix, tx2 = (set1(box.max.x) - s.ox) * s.ix;
+	vfloat ty1 = (set1(box.min.y) - s.oy) * s.iy, ty2 = (set1(box.max.y) - s.oy) * s.iy;
+	vfloat tz1 = (set1(box.min.z) - s.oz) * s.iz, tz2 = (set1(box.max.z) - s.oz) * s.iz;
+	vfloat tnear = vmax(vmax(vmin(tx1, tx2), vmin(ty1, ty2)), vmax(vmin(tz1, tz2), set1(0)));
+	vfloat tfar = vmin(vmin(vmax(tx1, tx2), vmax(ty1, ty2)), vmin(vmax(tz1, tz2), s.tmin));
+	return s.active & (tnear <= tfar);
+}
+
+//See Sphere::intersect()
+static inline void intersectSphere(PacketState& s, const PacketTable& table, int i)
+{
+	float p[SPHERE_COLUMNS];
+	for (int c = 0; c < SPHERE_COLUMNS; c++) p[c] = table.data[c * table.count + i];
+	vfloat vx = s.ox - set1(p[SPHERE_CX]), vy = s.oy - set1(p[SPHERE_CY]), vz = s.oz - set1(p[SPHERE_CZ]);
+	vfloat b = s.dx * vx + s.dy * vy + s.dz * vz;
+	vfloat len = vsqrt(vx * vx + vy * vy + vz * vz);
+	vfloat c = len * len - set1(p[SPHERE_R] * p[SPHERE_R]);
+	vfloat delta = b * b - c;
+	vmask valid = s.active & (delta >= set1(0.001f));
+	if (!any(valid)) return;
+
+	vfloat root = vsqrt(vmax(delta, set1(0)));
+	vfloat t1 = set1(0) - b - root;
+	vfloat t2 = root - b;
+	vfloat t = select(vabs(t1) < set1(0.001f), t2, t1);		//Starting on the surface: take the far root
+	updateHits(s, valid & (t > set1(0)), t, table.object[i]);
+}
+
+//See Plane::intersect() and Plane::isInside()
+static inline void intersectPlane(PacketState& s, const PacketTable& table, int i)
+{
+	float p[PLANE_COLUMNS];
+	for (int c = 0; c < PLANE_COLUMNS; c++) p[c] = table.data[c * table.count + i];
+	vfloat nx = set1(p[PLANE_NX]), ny = set1(p[PLANE_NY]), nz = set1(p[PLANE_NZ]);
+	vfloat dn = s.dx * nx + s.dy * ny + s.dz * nz;
+	vfloat t = (set1(p[PLANE_D]) - (s.ox * nx + s.oy * ny + s.oz * nz)) / dn;
+	vmask valid = s.active & (vabs(dn) >= set1(1.e-4f)) & (vabs(t) >= set1(1.e-4f)) & (t > set1(0));
+	if (!any(valid)) return;
+
+	vfloat qx = s.ox + s.dx * t, qy = s.oy + s.dy * t, qz = s.oz + s.dz * t;
+	vmask pos = valid, neg = valid;
+	for (int k = 0; k < 4; k++)
+	{
+		const float* e = p + PLANE_EDGES + 4*k;
+		vfloat side = qx * set1(e[0]) + qy * set1(e[1]) + qz * set1(e[2]) - set1(e[3]);
+		pos = pos & (side > set1(0));
+		neg = neg & (side < set1(0));
+	}
+	updateHits(s, pos | neg, t, table.object[i]);
+}
+
+//See Cylinder::intersect()
+static inline void intersectCylinder(PacketState& s, const PacketTable& table, int i)
+{
+	float p[CYL_COLUMNS];
+	for (int c = 0; c < CYL_COLUMNS; c++) p[c] = table.data[c * table.count + i];
+	vfloat zero = set1(0), eps = set1(0.001f);
+	vfloat ybot = set1(p[CYL_CY]), ytop = set1(p[CYL_CY] + p[CYL_H]);
+	vfloat vx = s.ox - set1(p[CYL_CX]), vz = s.oz - set1(p[CYL_CZ]);
+	vfloat a = s.dx * s.dx + s.dz * s.dz;
+	vfloat b = set1(2) * (s.dx * vx + s.dz * vz);
+	vfloat c = vx * vx + vz * vz - set1(p[CYL_R] * p[CYL_R]);
+	vfloat delta = b * b - set1(4) * a * c;
+	vmask valid = s.active & (delta >= eps);
+	if (!any(valid)) return;
+
+	vfloat root = vsqrt(vmax(delta, zero));
+	vfloat t1 = (zero - b - root) / (set1(2) * a);
+	vfloat t2 = (root - b) / (set1(2) * a);
+	valid = valid & (vabs(t1) >= eps) & (vabs(t2) >= eps);
+	vfloat p1 = vmin(t1, t2), p2 = vmax(t1, t2);
+
+	vfloat y1 = s.oy + s.dy * p1;
+	vfloat y2 = s.oy + s.dy * p2;
+	vmask side1 = (y1 <= ytop) & (y1 >= ybot);
+	vmask side2 = (y2 <= ytop) & (y2 >= ybot);
+
+	vfloat tcap = (ytop - s.oy) / s.dy;
+	vfloat cx = s.ox + s.dx * tcap - set1(p[CYL_CX]), cz = s.oz + s.dz * tcap - set1(p[CYL_CZ]);
+	vmask cap = side2 & (tcap >= eps) & (cx * cx + cz * cz <= set1(p[CYL_R] * p[CYL_R]));
+
+	vfloat t = select(side1, p1, tcap);
+	updateHits(s, valid & (side1 | cap) & (t > zero), t, table.object[i]);
+}
+
+//See Cone::intersect()
+static inline void intersectCone(PacketState& s, const PacketTable& table, int i)
+{
+	float p[CYL_COLUMNS];
+	for (int c = 0; c < CYL_COLUMNS; c++) p[c] = table.data[c * table.count + i];
+	vfloat zero = set1(0), eps = set1(0.001f);
+	float ratio = p[CYL_R] / p[CYL_H];
+	vfloat rh = set1(ratio * ratio);
+	vfloat ybot = set1(p[CYL_CY]), ytop = set1(p[CYL_CY] + p[CYL_H]);
+	vfloat vx = s.ox - set1(p[CYL_CX]), vz = s.oz - set1(p[CYL_CZ]);
+	vfloat hy = set1(p[CYL_H]) - s.oy + set1(p[CYL_CY]);
+	vfloat a = s.dx * s.dx + s.dz * s.dz - rh * s.dy * s.dy;
+	vfloat b = set1(2) * (s.dx * vx + s.dz * vz + rh * s.dy * hy);
+	vfloat c = vx * vx + vz * vz - rh * hy * hy;
+	vfloat delta = b * b - set1(4) * a * c;
+	vmask valid = s.active & (delta >= eps);
+	if (!any(valid)) return;
+
+	vfloat root = vsqrt(vmax(delta, zero));
+	vfloat t1 = (zero - b - root) / (set1(2) * a);
+	vfloat t2 = (root - b) / (set1(2) * a);
+	valid = valid & (vabs(t1) >= eps) & (vabs(t2) >= eps);
+	vfloat p1 = vmin(t1, t2), p2 = vmax(t1, t2);
+
+	vfloat y1 = s.oy + s.dy * p1;
+	vfloat y2 = s.oy + s.dy * p2;
+	vmask side1 = (y1 <= ytop) & (y1 >= ybot);
+	vmask side2 = (y2 <= ytop) & (y2 >= ybot);
+
+	vfloat t = select(side1, p1, p2);
+	updateHits(s, valid & (side1 | side2) & (t > zero), t, table.object[i]);
+}
+
+//Objects without a kernel are intersected one lane at a time
+static inline void intersectOther(PacketState& s, const PacketScene& scene, int object)
+{
+	alignas(64) float ox[WIDTH], oy[WIDTH], oz[WIDTH], dx[WIDTH], dy[WIDTH], dz[WIDTH], t[WIDTH];
+	store(ox, s.ox); store(oy, s.oy); store(oz, s.oz);
+	store(dx, s.dx); store(dy, s.dy); store(dz, s.dz);
+	SceneObject* obj = scene.objects[object];
+	for (int lane = 0; lane < WIDTH; lane++)
+		t[lane] = scene.intersectScalar(obj, ox[lane], oy[lane], oz[lane], dx[lane], dy[lane], dz[lane]);
+	vfloat tv = load(t);
+	updateHits(s, s.active & (tv > set1(0)), tv, object);
+}
+
+/**
+* Intersects lanes [first, first+count) of the packet with the scene,
+* walking the BVH once for the whole packet. A node is entered if any
+* lane hits its box; the nearer child (as seen by the first ray) is
+* visited first.
+*/
+static inline void closestPtPacket(const PacketScene& scene, RayPacket& packet, int first, int count)
+{
+	alignas(64) float buf[WIDTH];
+	PacketState s;
+	vmask active = laneMask(count);
+
+	//Unused lanes get a harmless ray that is masked out everywhere
+	for (int k = 0; k < WIDTH; k++) buf[k] = (k < count) ? packet.ox[first + k] : 0;
+	s.ox = load(buf);
+	for (int k = 0; k < WIDTH; k++) buf[k] = (k < count) ? packet.oy[first + k] : 0;
+	s.oy = load(buf);
+	for (int k = 0; k < WIDTH; k++) buf[k] = (k < count) ? packet.oz[first + k] : 0;
+	s.oz = load(buf);
+	for (int k = 0; k < WIDTH; k++) buf[k] = (k < count) ? packet.dx[first + k] : 0;
+	s.dx = load(buf);
+	for (int k = 0; k < WIDTH; k++) buf[k] = (k < count) ? packet.dy[first + k] : 0;
+	s.dy = load(buf);
+	for (int k = 0; k < WIDTH; k++) buf[k] = (k < count) ? packet.dz[first + k] : -1;
+	s.dz = load(buf);
+	s.ix = set1(1) / s.dx;
+	s.iy = set1(1) / s.dy;
+	s.iz = set1(1) / s.dz;
+	s.tmin = set1(1.e+6f);
+	s.index = set1(-1);
+	s.active = active;
+
+	float d0x = packet.dx[first], d0y = packet.dy[first], d0z = packet.dz[first];
+	int stack[BVH_STACK_SIZE];
+	int top = 0;
+	stack[top++] = 0;
+	while (top > 0)
+	{
+		int nodeIndex = stack[--top];
+		const BVHNode& node = scene.nodes[nodeIndex];
+		if (!any(hitBox(s, node.bounds))) continue;
+
+		if (node.count > 0)
+		{
+			const LeafRange& range = scene.leaves[nodeIndex];
+			for (int type = 0; type < NUM_PRIM_TYPES; type++)
+			{
+				const PacketTable& table = scene.tables[type];
+				for (int i = range.first[type]; i < range.first[type] + range.count[type]; i++)
+				{
+					switch (type)
+					{
+					case PRIM_SPHERE:   intersectSphere(s, table, i); break;
+					case PRIM_PLANE:    intersectPlane(s, table, i); break;
+					case PRIM_CYLINDER: intersectCylinder(s, table, i); break;
+					case PRIM_CONE:     intersectCone(s, table, i); break;
+					default:            intersectOther(s, scene, table.object[i]); break;
+					}
+				}
+			}
+		}
+		else
+		{
+			int left = nodeIndex + 1, right = node.start;
+			const AABB& lb = scene.nodes[left].bounds;
+			const AABB& rb = scene.nodes[right].bounds;
+			float dl = d0x * (lb.min.x + lb.max.x) + d0y * (lb.min.y + lb.max.y) + d0z * (lb.min.z + lb.max.z);
+			float dr = d0x * (rb.min.x + rb.max.x) + d0y * (rb.min.y + rb.max.y) + d0z * (rb.min.z + rb.max.z);
+			if (dl <= dr)
+			{
+				stack[top++] = right;
+				stack[top++] = left;
+			}
+			else
+			{
+				stack[top++] = left;
+				stack[top++] = right;
+			}
+		}
+	}
+
+	alignas(64) float index[WIDTH];
+	store(buf, s.tmin);
+	store(index, s.index);
+	for (int k = 0; k < count; k++)
+	{
+		packet.dist[first + k] = buf[k];
+		packet.index[first + k] = (int)index[k];
+	}
+}
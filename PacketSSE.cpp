@@ -0,0 +1,73 @@
+/*----------------------------------------------------------
+* COSC363  Ray Tracer
+*
+*  4-wide packet kernels using SSE2
+*  (always available on x86-64)
+-------------------------------------------------------------*/
+
+#include "RayPacket.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#include <immintrin.h>
+
+#if defined(__clang__)
+#pragma clang attribute push (__attribute__((target("sse2"))), apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("sse2")
+#pragma GCC optimize("fp-contract=off")	//No fused multiply-adds: the results must match the scalar code
+#endif
+
+namespace PacketSSE
+{
+	const int WIDTH = 4;
+
+	struct vfloat { __m128 v; };
+	struct vmask { __m128 m; };
+
+	static inline vfloat set1(float a) { vfloat r; r.v = _mm_set1_ps(a); return r; }
+	static inline vfloat load(const float* p) { vfloat r; r.v = _mm_load_ps(p); return r; }
+	static inline void store(float* p, vfloat a) { _mm_store_ps(p, a.v); }
+
+	static inline vfloat operator+(vfloat a, vfloat b) { vfloat r; r.v = _mm_add_ps(a.v, b.v); return r; }
+	static inline vfloat operator-(vfloat a, vfloat b) { vfloat r; r.v = _mm_sub_ps(a.v, b.v); return r; }
+	static inline vfloat operator*(vfloat a, vfloat b) { vfloat r; r.v = _mm_mul_ps(a.v, b.v); return r; }
+	static inline vfloat operator/(vfloat a, vfloat b) { vfloat r; r.v = _mm_div_ps(a.v, b.v); return r; }
+	static inline vfloat vsqrt(vfloat a) { vfloat r; r.v = _mm_sqrt_ps(a.v); return r; }
+	static inline vfloat vmin(vfloat a, vfloat b) { vfloat r; r.v = _mm_min_ps(a.v, b.v); return r; }
+	static inline vfloat vmax(vfloat a, vfloat b) { vfloat r; r.v = _mm_max_ps(a.v, b.v); return r; }
+	static inline vfloat vabs(vfloat a) { vfloat r; r.v = _mm_andnot_ps(_mm_set1_ps(-0.0f), a.v); return r; }
+
+	static inline vmask operator<(vfloat a, vfloat b) { vmask r; r.m = _mm_cmplt_ps(a.v, b.v); return r; }
+	static inline vmask operator>(vfloat a, vfloat b) { vmask r; r.m = _mm_cmpgt_ps(a.v, b.v); return r; }
+	static inline vmask operator<=(vfloat a, vfloat b) { vmask r; r.m = _mm_cmple_ps(a.v, b.v); return r; }
+	static inline vmask operator>=(vfloat a, vfloat b) { vmask r; r.m = _mm_cmpge_ps(a.v, b.v); return r; }
+	static inline vmask operator==(vfloat a, vfloat b) { vmask r; r.m = _mm_cmpeq_ps(a.v, b.v); return r; }
+	static inline vmask operator&(vmask a, vmask b) { vmask r; r.m = _mm_and_ps(a.m, b.m); return r; }
+	static inline vmask operator|(vmask a, vmask b) { vmask r; r.m = _mm_or_ps(a.m, b.m); return r; }
+
+	static inline vfloat select(vmask m, vfloat a, vfloat b)	//m ? a : b
+	{
+		vfloat r; r.v = _mm_or_ps(_mm_and_ps(m.m, a.v), _mm_andnot_ps(m.m, b.v)); return r;
+	}
+	static inline bool any(vmask m) { return _mm_movemask_ps(m.m) != 0; }
+	static inline vmask laneMask(int count)		//The first count lanes
+	{
+		vmask r; r.m = _mm_cmplt_ps(_mm_setr_ps(0, 1, 2, 3), _mm_set1_ps((float)count)); return r;
+	}
+
+#include "PacketKernels.inl"
+}
+
+void closestPtSSE(const PacketScene& scene, RayPacket& packet, int first, int count)
+{
+	PacketSSE::closestPtPacket(scene, packet, first, count);
+}
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+
+#endif
@@ -9,18 +9,53 @@
 #include "Plane.h"
 #include <math.h>
 
+/**
+* Computes the normal, the plane constant and the edge data once, so that
+* intersect() needs no cross products. The edge test of isInside() is the sign of
+* dot(cross(u, q - v), n) for each edge u starting at vertex v. That equals
+* dot(q - v, cross(n, u)) = dot(q, e) - dot(v, e) with e = cross(n, u), so each
+* edge is stored as e and the offset dot(v, e). A triangle repeats its first edge
+* in place of the fourth.
+*/
+void Plane::precompute()
+{
+	glm::vec3 v1 = c_ - b_;
+	glm::vec3 v2 = a_ - b_;
+	n_ = glm::normalize(glm::cross(v1, v2));
+	dist_ = glm::dot(n_, a_);
+
+	glm::vec3 from[4] = { a_, b_, c_, d_ };
+	glm::vec3 to[4] = { b_, c_, d_, a_ };
+	if (nverts_ == 3)
+	{
+		to[2] = a_;
+		from[3] = a_;
+		to[3] = b_;
+	}
+	for (int i = 0; i < 4; i++)
+	{
+		glm::vec3 e = glm::cross(n_, to[i] - from[i]);
+		edges_[i] = glm::vec4(e, glm::dot(from[i], e));
+	}
+
+	glm::vec3 axes[2] = { b_ - a_, (nverts_ == 3 ? c_ : d_) - a_ };
+	for (int i = 0; i < 2; i++)
+	{
+		glm::vec3 e = axes[i] / glm::dot(axes[i], axes[i]);
+		uvAxes_[i] = glm::vec4(e, glm::dot(a_, e));
+	}
+}
+
 /**
 * Plane's intersection method.  The input is a ray (p0, dir).
 * See slides Lec08-Slides 27, 29
 */
 float Plane::intersect(glm::vec3 p0, glm::vec3 dir)
 {
-	glm::vec3 n = normal(p0);
-	glm::vec3 vdif = a_ - p0;
-	float d_dot_n = glm::dot(dir, n);
+	float d_dot_n = glm::dot(dir, n_);
 	if (fabs(d_dot_n) < 1.e-4) return -1;
 
-	float t = glm::dot(vdif, n) / d_dot_n;
+	float t = (dist_ - glm::dot(p0, n_)) / d_dot_n;
 	if (fabs(t) < 0.0001) return -1;
 	glm::vec3 q = p0 + dir * t;
 
@@ -29,16 +64,12 @@ float Plane::intersect(glm::vec3 p0, glm::vec3 dir)
 }
 
 /**
-* Returns the unit normal vector at a given point.
-* Assumption: The input point p lies on the plane.
+* Returns the unit normal vector at a given point on the plane:
+* the precomputed normal, which is the same everywhere.
 */
-glm::vec3 Plane::normal(glm::vec3 p)
+glm::vec3 Plane::normal(glm::vec3)
 {
-	glm::vec3 v1 = c_ - b_;
-	glm::vec3 v2 = a_ - b_;
-	glm::vec3 n = glm::cross(v1, v2);
-	n = glm::normalize(n);
-	return n;
+	return n_;
 }
 
 /**
@@ -48,18 +79,10 @@ glm::vec3 Plane::normal(glm::vec3 p)
 */
 bool Plane::isInside(glm::vec3 q)
 {
-	glm::vec3 n = normal(q);     //Normal vector at the point of intersection
-	glm::vec3 ua = b_ - a_, ub = c_ - b_, uc = d_ - c_, ud = a_ - d_;
-	glm::vec3 va = q - a_, vb = q - b_, vc = q - c_, vd = q - d_;
-	if (nverts_ == 3) uc = a_ - c_;
-	float ka = glm::dot(glm::cross(ua, va), n);
-	float kb = glm::dot(glm::cross(ub, vb), n);
-	float kc = glm::dot(glm::cross(uc, vc), n);
-	float kd;
-	if (nverts_ == 4)
-		kd = glm::dot(glm::cross(ud, vd), n);
-	else
-		kd = ka;
+	float ka = glm::dot(q, glm::vec3(edges_[0])) - edges_[0].w;
+	float kb = glm::dot(q, glm::vec3(edges_[1])) - edges_[1].w;
+	float kc = glm::dot(q, glm::vec3(edges_[2])) - edges_[2].w;
+	float kd = glm::dot(q, glm::vec3(edges_[3])) - edges_[3].w;
 	if (ka > 0 && kb > 0 && kc > 0 && kd > 0) return true;
 	if (ka < 0 && kb < 0 && kc < 0 && kd < 0) return true;
 	else return false;
@@ -71,3 +94,44 @@ int  Plane::getNumVerts()
 {
 	return nverts_;
 }
+
+//Getter function for the vertices a, b, c, d (i = 0..3)
+glm::vec3 Plane::getVertex(int i)
+{
+	if (i == 0) return a_;
+	if (i == 1) return b_;
+	if (i == 2) return c_;
+	return d_;
+}
+
+//Getter function for the plane constant dot(n, p)
+float Plane::getPlaneConstant()
+{
+	return dist_;
+}
+
+//Getter function for the precomputed data of edge i (i = 0..3): in-plane edge normal and offset
+glm::vec4 Plane::getEdge(int i)
+{
+	return edges_[i];
+}
+
+/**
+* Planar texture coordinates: (0, 0) at vertex a, (1, 0) at b and (0, 1) at d
+* (at c for a triangle).
+*/
+glm::vec2 Plane::texcoord(glm::vec3 p)
+{
+	return glm::vec2(glm::dot(p, glm::vec3(uvAxes_[0])) - uvAxes_[0].w, glm::dot(p, glm::vec3(uvAxes_[1])) - uvAxes_[1].w);
+}
+
+//Returns the axis-aligned box enclosing the polygon's vertices
+AABB Plane::bounds()
+{
+	AABB box;
+	box.expand(a_);
+	box.expand(b_);
+	box.expand(c_);
+	if (nverts_ == 4) box.expand(d_);
+	return box;
+}
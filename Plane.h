@@ -20,15 +20,21 @@ private:
 	glm::vec3 c_ = glm::vec3(0);
 	glm::vec3 d_ = glm::vec3(0);
 	int nverts_ = 4;				//Number of vertices (3 or 4)
+	glm::vec3 n_ = glm::vec3(0);	//Unit normal
+	float dist_ = 0;				//Plane constant: dot(n_, p) for every point p on the plane
+	glm::vec4 edges_[4];			//Per edge: in-plane edge normal (xyz) and its offset (w), see precompute()
+	glm::vec4 uvAxes_[2];			//u along a->b and v along a->d (a->c for triangles): axis / length^2 (xyz), offset (w)
+
+	void precompute();
 
 public:	
 	Plane() = default;
 	
 	Plane(glm::vec3 pa, glm::vec3 pb, glm::vec3 pc, glm::vec3 pd) : 
-		a_(pa), b_(pb), c_(pc), d_(pd), nverts_(4) {}
+		a_(pa), b_(pb), c_(pc), d_(pd), nverts_(4) { precompute(); }
 
 	Plane(glm::vec3 pa, glm::vec3 pb, glm::vec3 pc) :
-		a_(pa), b_(pb), c_(pc),  nverts_(3) {}
+		a_(pa), b_(pb), c_(pc),  nverts_(3) { precompute(); }
 
 
 	bool isInside(glm::vec3 pt);
@@ -36,9 +42,19 @@ public:
 	float intersect(glm::vec3 posn, glm::vec3 dir);
 
 	int getNumVerts();
+
+	glm::vec3 getVertex(int i);
+
+	float getPlaneConstant();
+
+	glm::vec4 getEdge(int i);
 	
 	glm::vec3 normal(glm::vec3 pt);
 
+	AABB bounds();
+
+	glm::vec2 texcoord(glm::vec3 pt);
+
 };
 
 #endif //!H_PLANE
@@ -5,26 +5,20 @@
 -------------------------------------------------------------*/
 #include "Ray.h"
 
-//Finds the closest point of intersection of the current ray with scene objects
-void Ray::closestPt(std::vector<SceneObject*> &sceneObjects)
+//Finds the closest point of intersection of the current ray with scene objects,
+//using the bounding volume hierarchy built over them
+void Ray::closestPt(const CompiledScene& scene)
 {
-	glm::vec3 point(0,0,0);
-	float tmin = 1.e+6;
-    for(int i = 0;  i < sceneObjects.size();  i++)
+	float t;
+	if (scene.closestHit(p0, dir, index, t))
 	{
-        float t = sceneObjects[i]->intersect(p0, dir);
-		if(t > 0)        //Intersects the object
-		{
-			point = p0 + dir*t;
-			if(t < tmin)
-			{
-				hit = point;
-				index = i;
-				dist = t;
-				tmin = t;
-			}
-		}
+		hit = p0 + dir*t;
+		dist = t;
 	}
-
 }
 
+//Checks whether anything blocks the ray before it has travelled maxDist, without finding the closest point
+Occlusion Ray::occlusion(const CompiledScene& scene, float maxDist)
+{
+	return scene.occlusion(p0, dir, maxDist);
+}
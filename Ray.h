@@ -9,6 +9,7 @@
 #include <glm/glm.hpp>
 #include <vector>
 #include "SceneObject.h"
+#include "CompiledScene.h"
 
 class Ray
 {
@@ -19,6 +20,8 @@ public:
 	glm::vec3 hit = glm::vec3(0);		//The closest point of intersection on the ray
 	int index = -1;						//The index of the object that gives the closet point of intersection
 	float dist = 0;						//The distance from the p0 to hit along the ray.
+	float width = 0;					//Ray cone: width of the ray's footprint at p0
+	float spread = 0;					//Ray cone: growth of the width per unit distance
 
 	Ray() {}		//Default constructor
 
@@ -29,7 +32,16 @@ public:
 		dir = glm::normalize(direction);
 	}
 
-	void closestPt(std::vector<SceneObject*>& sceneObjects);
+	//Continues the ray cone of 'parent' from its hit point, the origin of this ray
+	void setCone(const Ray& parent)
+	{
+		width = parent.width + parent.spread * parent.dist;
+		spread = parent.spread;
+	}
+
+	void closestPt(const CompiledScene& scene);
+
+	Occlusion occlusion(const CompiledScene& scene, float maxDist);
 
 };
 #endif
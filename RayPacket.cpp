@@ -0,0 +1,141 @@
+/*----------------------------------------------------------
+* COSC363  Ray Tracer
+*
+*  The ray packet classes
+*  Hands the compiled scene to the packet kernels and picks the
+*  widest kernel supported by the CPU at run time. The
+*  kernels themselves are in PacketSSE.cpp, PacketAVX2.cpp
+*  and PacketAVX512.cpp.
+-------------------------------------------------------------*/
+
+#include "RayPacket.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define PACKET_X86
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+void closestPtSSE(const PacketScene& scene, RayPacket& packet, int first, int count);
+void closestPtAVX2(const PacketScene& scene, RayPacket& packet, int first, int count);
+void closestPtAVX512(const PacketScene& scene, RayPacket& packet, int first, int count);
+#endif
+
+void RayPacket::setRay(int lane, const Ray& ray)
+{
+	ox[lane] = ray.p0.x;  oy[lane] = ray.p0.y;  oz[lane] = ray.p0.z;
+	dx[lane] = ray.dir.x; dy[lane] = ray.dir.y; dz[lane] = ray.dir.z;
+}
+
+//Copies the result for one lane back into a ray, as Ray::closestPt() would have left it
+void RayPacket::getRay(int lane, Ray& ray)
+{
+	ray.p0 = glm::vec3(ox[lane], oy[lane], oz[lane]);
+	ray.dir = glm::vec3(dx[lane], dy[lane], dz[lane]);
+	ray.index = index[lane];
+	if (ray.index != -1)
+	{
+		ray.dist = dist[lane];
+		ray.hit = ray.p0 + ray.dir * ray.dist;
+	}
+}
+
+//Used by the kernels for objects without a packet kernel of their own
+static float intersectScalar(SceneObject* obj, float ox, float oy, float oz, float dx, float dy, float dz)
+{
+	return obj->intersect(glm::vec3(ox, oy, oz), glm::vec3(dx, dy, dz));
+}
+
+PacketTracer::PacketTracer()
+{
+	width_ = getMaxWidth();
+}
+
+/**
+* Returns the number of rays the widest available kernel handles at once:
+* 16 with AVX-512, 8 with AVX2, 4 with SSE, or 1 if there is no SIMD kernel.
+*/
+int PacketTracer::getMaxWidth()
+{
+#if defined(PACKET_X86)
+	static int maxWidth = 0;
+	if (maxWidth == 0)
+	{
+#if defined(_MSC_VER)
+		int info[4];
+		__cpuid(info, 1);
+		bool osxsave = (info[2] & (1 << 27)) != 0;
+		bool avx = (info[2] & (1 << 28)) != 0;
+		unsigned long long xcr0 = osxsave ? _xgetbv(0) : 0;
+		__cpuidex(info, 7, 0);
+		bool avx2 = avx && (xcr0 & 0x6) == 0x6 && (info[1] & (1 << 5)) != 0;
+		bool avx512 = (xcr0 & 0xe6) == 0xe6 && (info[1] & (1 << 16)) != 0;
+#else
+		__builtin_cpu_init();
+		bool avx2 = __builtin_cpu_supports("avx2");
+		bool avx512 = __builtin_cpu_supports("avx512f");
+#endif
+		maxWidth = avx512 ? 16 : (avx2 ? 8 : 4);
+	}
+	return maxWidth;
+#else
+	return 1;
+#endif
+}
+
+int PacketTracer::getWidth()
+{
+	return width_;
+}
+
+void PacketTracer::setWidth(int width)
+{
+	int maxWidth = getMaxWidth();
+	if (width >= 16 && maxWidth >= 16) width_ = 16;
+	else if (width >= 8 && maxWidth >= 8) width_ = 8;
+	else if (width >= 4 && maxWidth >= 4) width_ = 4;
+	else width_ = 1;
+}
+
+/**
+* Points the kernels at the tables of the compiled scene.
+* Must be called again after the scene is recompiled.
+*/
+void PacketTracer::build(const CompiledScene& scene)
+{
+	compiled_ = &scene;
+	const std::vector<BVHNode>& nodes = scene.getBVH().getNodes();
+	scene_.nodes = nodes.empty() ? nullptr : &nodes[0];
+	scene_.leaves = scene.getLeaves().empty() ? nullptr : &scene.getLeaves()[0];
+	for (int type = 0; type < NUM_PRIM_TYPES; type++)
+	{
+		const PrimTable& table = scene.getTable(type);
+		scene_.tables[type].data = table.data.data();
+		scene_.tables[type].object = table.object.data();
+		scene_.tables[type].count = table.count;
+	}
+	scene_.objects = scene.getNumObjects() == 0 ? nullptr : &scene.getObjects()[0];
+	scene_.intersectScalar = intersectScalar;
+}
+
+/**
+* Finds the closest hit of every ray in the packet, filling in dist and index.
+* Gives the same result as calling Ray::closestPt() on each ray.
+*/
+void PacketTracer::closestPt(RayPacket& packet)
+{
+	for (int first = 0; first < packet.count; first += width_)
+	{
+		int count = (packet.count - first < width_) ? packet.count - first : width_;
+#if defined(PACKET_X86)
+		if (scene_.nodes != nullptr && width_ == 16) { closestPtAVX512(scene_, packet, first, count); continue; }
+		if (scene_.nodes != nullptr && width_ == 8) { closestPtAVX2(scene_, packet, first, count); continue; }
+		if (scene_.nodes != nullptr && width_ == 4) { closestPtSSE(scene_, packet, first, count); continue; }
+#endif
+		for (int lane = first; lane < first + count; lane++)
+		{
+			glm::vec3 p0(packet.ox[lane], packet.oy[lane], packet.oz[lane]);
+			glm::vec3 dir(packet.dx[lane], packet.dy[lane], packet.dz[lane]);
+			if (!compiled_->closestHit(p0, dir, packet.index[lane], packet.dist[lane])) packet.index[lane] = -1;
+		}
+	}
+}
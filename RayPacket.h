@@ -0,0 +1,78 @@
+/*----------------------------------------------------------
+* COSC363  Ray Tracer
+*
+*  The ray packet classes
+*  A RayPacket holds up to 16 coherent rays (e.g. neighbouring
+*  primary rays) in structure-of-arrays form. PacketTracer
+*  finds the closest hit of all rays in a packet at once,
+*  using SSE (4 rays), AVX2 (8 rays) or AVX-512 (16 rays)
+*  kernels, whichever is the widest the CPU supports.
+-------------------------------------------------------------*/
+
+#ifndef H_RAYPACKET
+#define H_RAYPACKET
+
+#include <glm/glm.hpp>
+#include <vector>
+#include "SceneObject.h"
+#include "CompiledScene.h"
+#include "Ray.h"
+
+const int MAX_PACKET = 16;
+
+struct RayPacket
+{
+	alignas(64) float ox[MAX_PACKET];	//Ray origins
+	alignas(64) float oy[MAX_PACKET];
+	alignas(64) float oz[MAX_PACKET];
+	alignas(64) float dx[MAX_PACKET];	//Unit ray directions
+	alignas(64) float dy[MAX_PACKET];
+	alignas(64) float dz[MAX_PACKET];
+	alignas(64) float dist[MAX_PACKET];	//Output: distance to the closest hit
+	int index[MAX_PACKET];				//Output: index of the closest object, -1 if none
+	int count = 0;						//Number of rays in use
+
+	void setRay(int lane, const Ray& ray);
+	void getRay(int lane, Ray& ray);
+};
+
+//One table of the compiled scene, as plain pointers for the packet kernels
+struct PacketTable
+{
+	const float* data = nullptr;		//Column c of entry i is data[c*count + i]
+	const int* object = nullptr;
+	int count = 0;
+};
+
+//Everything the kernels need to traverse the compiled scene
+struct PacketScene
+{
+	const BVHNode* nodes = nullptr;
+	const LeafRange* leaves = nullptr;
+	PacketTable tables[NUM_PRIM_TYPES];
+	SceneObject* const* objects = nullptr;
+	float (*intersectScalar)(SceneObject* obj, float ox, float oy, float oz, float dx, float dy, float dz) = nullptr;
+};
+
+class PacketTracer
+{
+private:
+	PacketScene scene_;
+	int width_ = 1;				//Rays intersected per kernel call (1 = no SIMD kernel)
+	const CompiledScene* compiled_ = nullptr;
+
+public:
+	PacketTracer();
+
+	void build(const CompiledScene& scene);
+
+	void closestPt(RayPacket& packet);
+
+	int getWidth();
+
+	void setWidth(int width);	//Restricts the kernel width (for testing); clamped to what the CPU supports
+
+	static int getMaxWidth();
+};
+
+#endif //!H_RAYPACKET
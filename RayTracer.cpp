@@ -1,6 +1,16 @@
 #include <iostream>
 #include <cmath>
 #include <vector>
+#include <chrono>
+#include <future>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <cstring>
+#include <cstdlib>
+#include <cstdio>
+#include <string>
 #include <glm/glm.hpp>
 #include "Sphere.h"
 #include "SceneObject.h"
@@ -8,344 +18,787 @@
 #include "Plane.h"
 #include "Cylinder.h"
 #include "Cone.h"
-#include "TextureBMP.h"
+#include "TriangleMesh.h"
+#include "SceneFile.h"
+#include "Texture.h"
+#include "CompiledScene.h"
+#include "TileRenderer.h"
+#include "RayPacket.h"
+#include "ImageWriter.h"
+#include "Wavefront.h"
+#include "DirtyTracker.h"
+#include "Animation.h"
 #include <GL/freeglut.h>
 
 using namespace std;
 
 const float WIDTH = 20.0;  
 const float HEIGHT = 20.0;
-const float EDIST = 40.0;		//The distance of the image plane from the camera/origin
 const int NUMDIV = 500;			//The number of cells(subdivisions of the image plane) along xand y directions
-const int MAX_STEPS = 4;
+const int TILE_SIZE = 16;		//The width and height of the tiles handed to the worker threads, in cells
 const float XMIN = -WIDTH * 0.5;
 const float XMAX =  WIDTH * 0.5;
 const float YMIN = -HEIGHT * 0.5;
 const float YMAX =  HEIGHT * 0.5;
 
 vector<SceneObject*> sceneObjects;
-TextureBMP texture1;
-TextureBMP texture2;
+SceneFile sceneFile;							//The scene description; owns the scene objects
+CompiledScene scene;
+PacketTracer packetTracer;
+TextureRegistry textureRegistry;				//Owns the textures; each file is loaded once
+vector<const Texture*> textures;				//In the order they are declared in the scene file
+int imageWidth = NUMDIV;						//Framebuffer size in cells; NUMDIV x NUMDIV in the window
+int imageHeight = NUMDIV;
+vector<glm::vec3> framebuffer(NUMDIV * NUMDIV);	//Traced colour of every cell, row by row
+bool framebufferValid = false;					//Whether framebuffer shows the current scene and camera
+DirtyTracker dirtyTracker;						//Cells an edit of an object or light has made stale
+vector<glm::vec3> firstPass;					//One-ray-per-cell colours, before anti-aliasing
+vector<int> objectIds;							//Object seen through the centre of every cell, -1 if none
+int aaLevels = 2;								//Times an edge cell may be split into 4 (0: no anti-aliasing)
+float aaThreshold = 0.1;						//Colour difference that makes a cell an edge
+glm::vec3 eye(0., 0., 0.);						//Camera position
+float viewDist = 40;							//The distance of the image plane from the camera
+float viewWidth = 20;							//The size of the image plane
+float viewHeight = 20;
+vector<Light> lights;							//From the scene file
+Animation animation;							//The scene file's keyframes
+ShadingParams shading;							//Lights, fog and background, from the scene file
+GLuint framebufferTex = 0;						//Texture the front buffer is drawn from
+TileRenderer renderer;
+const int PRESENT_INTERVAL = 30;				//Milliseconds between updates of the window while rendering
+bool progressive = false;						//Whether the window shows progressive previews, see progressiveStep()
+float progressiveTime = 10;						//Seconds a preview may keep accumulating samples
+int progressiveSamples = 64;					//Samples per cell at which it stops anyway
+atomic<bool> renderCancel(false);				//Set to make the render in progress stop early
+bool backgroundRender = false;					//Whether renders run on the render thread and present their tiles
+
+bool initializeScene(const char* filename);
+
+//Whether the colours differ by more than aaThreshold in any channel
+bool contrasts(const glm::vec3* cols, int n)
+{
+	glm::vec3 lo = cols[0], hi = cols[0];
+	for (int k = 1; k < n; k++)
+	{
+		lo = glm::min(lo, cols[k]);
+		hi = glm::max(hi, cols[k]);
+	}
+	glm::vec3 d = hi - lo;
+	return d.x > aaThreshold || d.y > aaThreshold || d.z > aaThreshold;
+}
 
-//---------------------------------------------------------------------------------- 
-//   Computes the colour value obtained by tracing a ray and finding its 
-//     closest point of intersection with objects in the scene.
-//----------------------------------------------------------------------------------
-glm::vec3 trace(Ray ray, int step)
+//Whether cell (i, j) lies on an edge: it shows a different object from one of its
+//4 neighbours, or its first-pass colour contrasts with theirs
+bool needsRefinement(int i, int j)
 {
-	glm::vec3 backgroundCol(1);
-	glm::vec3 lightPos(20, 40, -20);
-	glm::vec3 spotlightPos(20, 30, -100);
-	glm::vec3 spotlightDir(-20, -30, 15);
-	float cutoff = 12;
-	float z1 = -40, z2 = -140, y1=50, y2=-15;
-	glm::vec3 color(0);
-	SceneObject* obj;
-
-    ray.closestPt(sceneObjects);					//Compare the ray with all objects in the scene
-    if(ray.index == -1) return backgroundCol;		//no intersection
-	obj = sceneObjects[ray.index];					//object on which the closest point of intersection is found
-
-	if (ray.index == 0) //floor plane
-	{   //chequered pattern  
-		int width = 5;   
-		int iz = (ray.hit.z) / width;
-		int ix = (ray.hit.x - 50) / width;
-		int k = iz % 2, k2 = ix % 2;
-		if (k == k2) color = glm::vec3(0.5, 0, 0);
-		else color = glm::vec3(1, 0.84, 0);
-		obj->setColor(color);
-	} 
-	else if (ray.index == 1) //back plane
+	int c = j*imageWidth + i;
+	int neighbours[4] = { i > 0 ? c - 1 : c, i + 1 < imageWidth ? c + 1 : c, j > 0 ? c - imageWidth : c, j + 1 < imageHeight ? c + imageWidth : c };
+	for (int k = 0; k < 4; k++)
 	{
-		float texcoords = (ray.hit.x + 40) / (40+40);
-		float texcoordt = (ray.hit.y + 16) / (30+16);
-		if (texcoords > 0 && texcoords < 1 && texcoordt > 0 && texcoordt < 1)
-		{
-			color = texture1.getColorAt(texcoords, texcoordt);
-			obj->setColor(color);
-		}
+		int n = neighbours[k];
+		glm::vec3 pair[2] = { firstPass[c], firstPass[n] };
+		if (objectIds[n] != objectIds[c] || contrasts(pair, 2)) return true;
+	}
+	return false;
+}
+
+//Where the cells lie on the image plane: cell (i, j) has its lower left corner at
+//(xmin + i*cellX, ymin + j*cellY)
+void imagePlane(float& xmin, float& ymin, float& cellX, float& cellY)
+{
+	float aspect = (float)imageWidth / imageHeight;		//Non-square images widen the view, keeping square cells
+	float xmax = viewWidth * 0.5 * aspect, ymax = viewHeight * 0.5;
+	xmin = -viewWidth * 0.5 * aspect;
+	ymin = -viewHeight * 0.5;
+	cellX = (xmax-xmin)/imageWidth;  //cell width
+	cellY = (ymax-ymin)/imageHeight;  //cell height
+}
+
+//Shading parameters for a tile: the hits of its primary rays all lie in the tile's
+//frustum, so only the lights whose influence reaches that frustum can light them
+ShadingParams tileShading(const Tile& tile, vector<int>& tileLights)
+{
+	float xmin, ymin, cellX, cellY;
+	imagePlane(xmin, ymin, cellX, cellY);
+	float xl = xmin + tile.x0*cellX, xr = xmin + tile.x1*cellX;
+	float yb = ymin + tile.y0*cellY, yt = ymin + tile.y1*cellY;
+	glm::vec3 normals[5] = { glm::vec3(viewDist, 0, xl), glm::vec3(-viewDist, 0, -xr),
+		glm::vec3(0, viewDist, yb), glm::vec3(0, -viewDist, -yt), glm::vec3(0, 0, -1) };
+	glm::vec4 planes[5];
+	for (int k = 0; k < 5; k++)
+	{
+		glm::vec3 n = glm::normalize(normals[k]);
+		planes[k] = glm::vec4(n, -glm::dot(n, eye));
 	}
-	else if (ray.index == 2) //earth sphere
+	tileLights.clear();
+	for (size_t i = 0; i < lights.size(); i++)
+		if (lights[i].inFrustum(planes, 5)) tileLights.push_back(i);
+	ShadingParams params = shading;
+	params.primaryLights = &tileLights;
+	return params;
+}
+
+//---Double buffering --------------------------------------------------------------------
+// In the window the workers trace into framebuffer, the back buffer, while the
+// GLUT thread draws from frontBuffer. Each tile is copied to the front buffer as
+// soon as a pass has finished with it, so the image fills in while it is traced.
+//---------------------------------------------------------------------------------------
+vector<glm::vec3> frontBuffer(NUMDIV * NUMDIV);	//The colours shown in the window
+mutex frontMutex;								//Guards frontBuffer and frontChanged
+bool frontChanged = true;						//Whether frontBuffer has tiles the texture lacks
+
+//Copies a tile of the framebuffer to the front buffer; called by the workers
+void presentTile(const Tile& tile)
+{
+	if (!backgroundRender) return;
+	lock_guard<mutex> guard(frontMutex);
+	for (int j = tile.y0; j < tile.y1; j++)
+		copy(framebuffer.begin() + j*imageWidth + tile.x0, framebuffer.begin() + j*imageWidth + tile.x1, frontBuffer.begin() + j*imageWidth + tile.x0);
+	frontChanged = true;
+}
+
+//---Renders the scene into the framebuffer ----------------------------------------------
+// The cells are traced in tiles by the worker pool. Each tile's rays go through
+// a wavefront tracer: primary and secondary rays alike are intersected in
+// packets of up to 16, a wave at a time.
+// The first pass traces one ray through the centre of every cell. The second
+// pass anti-aliases adaptively: a cell whose colour contrasts with a neighbour's,
+// or that shows a different object, is split into 4 squares, each sampled once
+// at a low-discrepancy position. Squares whose 4 samples still contrast are split
+// again, up to aaLevels times. A cell's colour is the area-weighted mean of its
+// final squares.
+// After an edit of an object or light, only the cells dirtyTracker has marked
+// are traced again, and only those and their neighbours anti-aliased again.
+// Setting renderCancel makes the remaining tiles return at once.
+//---------------------------------------------------------------------------------------
+void render()
+{
+	float xmin, ymin, cellX, cellY;
+	imagePlane(xmin, ymin, cellX, cellY);
+	float pixelSpread = cellX / viewDist;		//Ray cone of a primary ray: one cell wide on the image plane
+	if (!framebufferValid || dirtyTracker.isAllDirty())
+	{
+		framebuffer.resize(imageWidth * imageHeight);
+		firstPass.resize(imageWidth * imageHeight);
+		objectIds.resize(imageWidth * imageHeight);
+		dirtyTracker.reset(imageWidth, imageHeight, TILE_SIZE, scene.getBounds());
+	}
+	//Whether cell (i, j) or one of its 4 neighbours is dirty, so may need anti-aliasing again
+	auto nearDirty = [&](int i, int j)
 	{
-		glm::vec3 d = ray.hit - glm::vec3(-5.0, -1.0, -80.0); //earth location
-		d = glm::normalize(d);
-		float texcoords = 0.5 + atan2(d.x, d.z) / (2 * 3.14159);
-		float texcoordt = 0.5 - asin(-d.y) / 3.14159;
-		if (texcoords > 0 && texcoords < 1 && texcoordt > 0 && texcoordt < 1)
+		return dirtyTracker.isDirty(i, j) || (i > 0 && dirtyTracker.isDirty(i - 1, j)) || (i + 1 < imageWidth && dirtyTracker.isDirty(i + 1, j))
+			|| (j > 0 && dirtyTracker.isDirty(i, j - 1)) || (j + 1 < imageHeight && dirtyTracker.isDirty(i, j + 1));
+	};
+
+	renderer.render(imageWidth, imageHeight, TILE_SIZE, [&](const Tile& tile)
+	{
+		if (renderCancel || !dirtyTracker.isTileDirty(tile, 0)) return;
+		//One ray per dirty cell, traced by this thread's wavefront tracer
+		thread_local WavefrontTracer tracer;
+		thread_local vector<PathRay> primary;
+		thread_local vector<int> pixelOf;			//Framebuffer index of every ray's cell
+		thread_local vector<glm::vec3> colors;
+		thread_local vector<int> ids;
+		thread_local vector<int> tileLights;
+		thread_local PixelRecord record;
+		ShadingParams params = tileShading(tile, tileLights);
+		primary.clear();
+		pixelOf.clear();
+		for (int j = tile.y0; j < tile.y1; j++)	//Scan every row of the tile
+		{
+			float yp = ymin + j*cellY;
+			for (int i = tile.x0; i < tile.x1; i++)
+			{
+				if (!dirtyTracker.isDirty(i, j)) continue;
+				float xp = xmin + i*cellX;
+				PathRay ray;
+				ray.p0 = eye;
+				ray.dir = glm::normalize(glm::vec3(xp+0.5*cellX, yp+0.5*cellY, -viewDist));	//direction of the primary ray
+				ray.spread = pixelSpread;
+				ray.pixel = primary.size();
+				primary.push_back(ray);
+				pixelOf.push_back(j*imageWidth + i);
+			}
+		}
+		colors.assign(primary.size(), glm::vec3(0));
+		ids.assign(primary.size(), -1);
+		record.clear(primary.size());
+		record.sceneBox = dirtyTracker.getSceneBox();
+		tracer.trace(primary, params, &colors[0], &ids[0], &record);
+		dirtyTracker.clearPixels(tile, true);
+		dirtyTracker.add(tile, record, pixelOf);
+		for (size_t k = 0; k < pixelOf.size(); k++)
 		{
-			color = texture2.getColorAt(texcoords, texcoordt);
-			obj->setColor(color);
+			framebuffer[pixelOf[k]] = firstPass[pixelOf[k]] = colors[k];
+			objectIds[pixelOf[k]] = ids[k];
 		}
+		presentTile(tile);
+	});
+
+	if (aaLevels > 0 && !renderCancel)
+	{
+		//The tiles compare against their neighbours' first-pass colours
+		renderer.render(imageWidth, imageHeight, TILE_SIZE, [&](const Tile& tile)
+		{
+			if (renderCancel || !dirtyTracker.isTileDirty(tile, 1)) return;
+			//A square of a cell still to be sampled: corner (x, y) and size, in cells
+			struct Square
+			{
+				float x, y, size;
+				int cell;			//Index into refined
+			};
+			thread_local WavefrontTracer tracer;
+			thread_local vector<int> refined;			//Framebuffer index of every cell being refined
+			thread_local vector<glm::vec3> sums;		//Their colours so far
+			thread_local vector<int> sampleCount;
+			thread_local vector<Square> squares, next;
+			thread_local vector<PathRay> rays;
+			thread_local vector<glm::vec3> colors;
+			thread_local vector<int> ids;
+			thread_local vector<int> tileLights;
+			thread_local vector<int> pixelOf;
+			thread_local PixelRecord record;
+
+			refined.clear();
+			squares.clear();
+			for (int j = tile.y0; j < tile.y1; j++)
+				for (int i = tile.x0; i < tile.x1; i++)
+				{
+					if (!nearDirty(i, j)) continue;
+					if (!needsRefinement(i, j))
+					{
+						framebuffer[j*imageWidth + i] = firstPass[j*imageWidth + i];
+						continue;
+					}
+					for (int k = 0; k < 4; k++)
+						squares.push_back({ (float)i + 0.5f * (k & 1), (float)j + 0.5f * (k >> 1), 0.5f, (int)refined.size() });
+					refined.push_back(j*imageWidth + i);
+				}
+			sums.assign(refined.size(), glm::vec3(0));
+			sampleCount.assign(refined.size(), 0);
+			ShadingParams params = tileShading(tile, tileLights);
+
+			for (int level = 1; !squares.empty(); level++)
+			{
+				rays.resize(squares.size());
+				pixelOf.resize(squares.size());
+				for (size_t k = 0; k < squares.size(); k++)
+				{
+					const Square& sq = squares[k];
+					//Position in the square from the R2 sequence, continued over all of the cell's samples
+					int n = ++sampleCount[sq.cell];
+					float u = 0.5f + n * 0.7548776662f, v = 0.5f + n * 0.5698402910f;
+					u -= floor(u);
+					v -= floor(v);
+					float xp = xmin + (sq.x + sq.size * u) * cellX, yp = ymin + (sq.y + sq.size * v) * cellY;
+					PathRay& ray = rays[k];
+					ray = PathRay();
+					ray.p0 = eye;
+					ray.dir = glm::normalize(glm::vec3(xp, yp, -viewDist));
+					ray.spread = pixelSpread * sq.size;
+					ray.pixel = k;
+					pixelOf[k] = refined[sq.cell];
+				}
+				colors.assign(rays.size(), glm::vec3(0));
+				ids.assign(rays.size(), -1);
+				record.clear(rays.size());
+				record.sceneBox = dirtyTracker.getSceneBox();
+				tracer.trace(rays, params, &colors[0], &ids[0], &record);
+				dirtyTracker.add(tile, record, pixelOf);
+
+				//The 4 squares of a split are consecutive: split them again where they contrast
+				next.clear();
+				for (size_t k = 0; k < squares.size(); k += 4)
+				{
+					bool split = (level < aaLevels) && (contrasts(&colors[k], 4) || ids[k] != ids[k+1] || ids[k] != ids[k+2] || ids[k] != ids[k+3]);
+					for (int m = 0; m < 4; m++)
+					{
+						const Square& sq = squares[k + m];
+						if (!split)
+						{
+							sums[sq.cell] += (sq.size * sq.size) * colors[k + m];
+							continue;
+						}
+						float h = 0.5f * sq.size;
+						for (int q = 0; q < 4; q++) next.push_back({ sq.x + h * (q & 1), sq.y + h * (q >> 1), h, sq.cell });
+					}
+				}
+				squares.swap(next);
+			}
+
+			for (size_t c = 0; c < refined.size(); c++) framebuffer[refined[c]] = sums[c];
+			presentTile(tile);
+		});
 	}
 
-	Ray R(ray.hit, spotlightPos - ray.hit);
-	R.closestPt(sceneObjects);
-	if (R.index == -1) color = obj->lighting(lightPos, spotlightPos, spotlightDir, cutoff, -ray.dir, ray.hit);
-	else color = obj->lighting(lightPos, -ray.dir, ray.hit);
-
-	//creates shadow ray from point of intersection to light source
-	glm::vec3 lightVec = lightPos - ray.hit; 
-	Ray shadowRay(ray.hit, lightVec);
-	shadowRay.closestPt(sceneObjects);
-	if (shadowRay.index > -1 && shadowRay.dist < glm::length(lightVec)) {
-		SceneObject* shadowObj = sceneObjects[shadowRay.index];
-		if (shadowObj->isTransparent() || shadowObj->isRefractive()) color *= 0.6f;
-		else color *= 0.2f;
+	if (renderCancel)		//Stopped part way: the next render starts afresh
+	{
+		framebufferValid = false;
+		return;
 	}
+	dirtyTracker.clearDirty();
+	framebufferValid = true;
+}
 
-	//creates reflection ray
-	if (obj->isReflective() && step < MAX_STEPS) 
-	{ 
-		glm::vec3 normalVec = obj->normal(ray.hit);
-		if ((ray.index != 3 && ray.index != 4) || normalVec.z > 0) {
-			float rho = obj->getReflectionCoeff();
-			glm::vec3 reflectedDir = glm::reflect(ray.dir, normalVec);
-			Ray reflectedRay(ray.hit, reflectedDir);
-			glm::vec3 reflectedColor = trace(reflectedRay, step + 1);
-			color = color + (rho * reflectedColor);
+//---Progressive rendering -------------------------------------------------------------
+// A preview that is quick to appear and improves while it is shown. Passes of one
+// ray per 8x8, 4x4, 2x2 and 1x1 block of cells come first, each filling its blocks
+// with the ray's colour; a block's ray goes through the centre of its first cell,
+// so the blocks already traced by the pass before are skipped and the 4 passes
+// together trace every cell once. Passes of one more sample per cell, at the
+// low-discrepancy positions of the anti-aliasing pass, then accumulate into
+// 'accumulation' until progressiveSamples or progressiveTime is reached.
+// The passes run in bands of rows on the render thread, which checks between bands
+// whether it has been cancelled.
+//---------------------------------------------------------------------------------------
+struct Progress
+{
+	bool running = false;
+	int blockSize = 8;				//Block size of the current coarse pass; 0 once accumulating
+	int samples = 0;				//Samples per cell in accumulation
+	int row = 0;					//First row of cells of the current pass not yet traced
+	chrono::steady_clock::time_point start;
+};
+Progress progress;
+vector<glm::vec3> accumulation;					//Sum of every cell's samples
+
+//Traces rows [row0, row1) of the current pass; row0 must be a multiple of TILE_SIZE
+void progressiveBand(int row0, int row1)
+{
+	float xmin, ymin, cellX, cellY;
+	imagePlane(xmin, ymin, cellX, cellY);
+	float pixelSpread = cellX / viewDist;
+	int block = progress.blockSize;
+	int n = progress.samples;
+	//Position in the cell from the R2 sequence, as in render()'s anti-aliasing pass
+	float u = 0.5f + n * 0.7548776662f, v = 0.5f + n * 0.5698402910f;
+	u -= floor(u);
+	v -= floor(v);
+
+	renderer.render(imageWidth, row1 - row0, TILE_SIZE, [&](const Tile& bandTile)
+	{
+		if (renderCancel) return;
+		Tile tile = bandTile;
+		tile.y0 += row0;
+		tile.y1 += row0;
+		thread_local WavefrontTracer tracer;
+		thread_local vector<PathRay> rays;
+		thread_local vector<int> pixelOf;
+		thread_local vector<glm::vec3> colors;
+		thread_local vector<int> ids;
+		thread_local vector<int> tileLights;
+		ShadingParams params = tileShading(tile, tileLights);
+		rays.clear();
+		pixelOf.clear();
+		int step = (block > 0) ? block : 1;
+		for (int j = tile.y0; j < tile.y1; j += step)		//The tiles start on block boundaries
+			for (int i = tile.x0; i < tile.x1; i += step)
+			{
+				if (block > 0 && block < 8 && i % (2*block) == 0 && j % (2*block) == 0) continue;	//Traced by the coarser pass
+				PathRay ray;
+				ray.p0 = eye;
+				if (block > 0)
+				{
+					float xp = xmin + i*cellX, yp = ymin + j*cellY;
+					ray.dir = glm::normalize(glm::vec3(xp+0.5*cellX, yp+0.5*cellY, -viewDist));
+				}
+				else ray.dir = glm::normalize(glm::vec3(xmin + (i + u) * cellX, ymin + (j + v) * cellY, -viewDist));
+				ray.spread = pixelSpread;
+				ray.pixel = rays.size();
+				rays.push_back(ray);
+				pixelOf.push_back(j*imageWidth + i);
+			}
+		if (rays.empty()) return;
+		colors.assign(rays.size(), glm::vec3(0));
+		ids.assign(rays.size(), -1);
+		tracer.trace(rays, params, &colors[0], &ids[0]);
+		for (size_t k = 0; k < rays.size(); k++)
+		{
+			int c = pixelOf[k];
+			if (block == 0)
+			{
+				accumulation[c] += colors[k];
+				framebuffer[c] = accumulation[c] / (float)(n + 1);
+				continue;
+			}
+			int i = c % imageWidth, j = c / imageWidth;
+			for (int y = j; y < min(j + block, tile.y1); y++)
+				for (int x = i; x < min(i + block, tile.x1); x++) framebuffer[y*imageWidth + x] = colors[k];
+			firstPass[c] = accumulation[c] = colors[k];
+			objectIds[c] = ids[k];
 		}
-	}
+		presentTile(tile);
+	});
+}
 
-	//creates straight transparent ray
-	if (obj->isTransparent() && !obj->isRefractive() && step < MAX_STEPS)
+/**
+* Traces the next band of the current progressive preview, moving on to the next
+* pass as each one is finished. Returns false once the preview is complete.
+*/
+bool progressiveStep()
+{
+	if (!progress.running) return false;
+	if (progress.row >= imageHeight)		//Pass finished
 	{
-		float trans_c = obj->getTransparencyCoeff();
-		Ray transparentRay(ray.hit, ray.dir);
-		glm::vec3 transColor = trace(transparentRay, step + 1);
-		color = color + (trans_c * transColor);
+		progress.row = 0;
+		if (progress.blockSize > 1) progress.blockSize /= 2;
+		else
+		{
+			progress.blockSize = 0;
+			progress.samples++;
+			double seconds = chrono::duration<double>(chrono::steady_clock::now() - progress.start).count();
+			if (progress.samples >= progressiveSamples || seconds >= progressiveTime)
+			{
+				progress.running = false;
+				cout << "Preview: " << progress.samples << " samples per cell in " << seconds << " s." << endl;
+				return false;
+			}
+		}
 	}
+	//A band of whole tiles; the coarse passes are cheap, so take more rows at once
+	int rows = TILE_SIZE * ((progress.blockSize > 1) ? progress.blockSize * progress.blockSize / 4 : 1);
+	progressiveBand(progress.row, min(progress.row + rows, imageHeight));
+	progress.row += rows;
+	return true;
+}
 
-	//creates refracted ray for sphere
-	if (obj->isRefractive() && obj->isTransparent() && step < MAX_STEPS)
+//Starts a new progressive preview of the current scene and camera
+void startProgressive()
+{
+	framebuffer.resize(imageWidth * imageHeight);
+	firstPass.resize(imageWidth * imageHeight);
+	objectIds.resize(imageWidth * imageHeight);
+	accumulation.assign(imageWidth * imageHeight, glm::vec3(0));
+	progress = Progress();
+	progress.running = true;
+	progress.start = chrono::steady_clock::now();
+	dirtyTracker.markAll();		//It has no record of the preview's rays
+	framebufferValid = true;
+}
+
+//---The render thread ---------------------------------------------------------------
+// In the window all tracing runs on this thread (and the tile workers), never in a
+// GLUT callback. The GLUT thread hands it work with startRender(); before changing
+// anything a render reads (camera, scene objects, lights, settings) it calls
+// stopRender(), which cancels the render in progress and waits the few
+// milliseconds until the workers have finished their current tiles.
+//---------------------------------------------------------------------------------------
+thread renderThread;
+mutex renderMutex;
+condition_variable renderWake;					//Signals renderRequested or renderQuit
+condition_variable renderIdle;					//Signals that renderBusy has been cleared
+bool renderRequested = false;
+bool renderBusy = false;
+bool renderQuit = false;
+
+void renderLoop()
+{
+	while (true)
 	{
-		float refrac_c = obj->getRefractionCoeff();
-		float refrac_i = obj->getRefractiveIndex();
-		glm::vec3 n = obj->normal(ray.hit);
-		glm::vec3 g = glm::refract(ray.dir, n, 1/refrac_i);
-		Ray refractedRay(ray.hit, g);
-		refractedRay.closestPt(sceneObjects);
-		glm::vec3 m = obj->normal(refractedRay.hit);
-		glm::vec3 h = glm::refract(refractedRay.dir, -m, refrac_i); // 1/eta
-		Ray refractedRay2(refractedRay.hit, h);
-		glm::vec3 refractedColor = trace(refractedRay2, step + 1);
-		color = color + (refrac_c * refractedColor);
+		{
+			unique_lock<mutex> lock(renderMutex);
+			renderWake.wait(lock, [] { return renderRequested || renderQuit; });
+			if (renderQuit) return;
+			renderRequested = false;
+			renderBusy = true;
+			renderCancel = false;
+		}
+		if (!progressive)
+		{
+			if (!framebufferValid || dirtyTracker.getNumDirty() > 0) render();
+		}
+		else
+		{
+			if (!framebufferValid) startProgressive();
+			while (!renderCancel && progressiveStep()) {}
+			if (renderCancel) framebufferValid = false;		//A pass was cut short: start again next time
+		}
+		lock_guard<mutex> guard(renderMutex);
+		renderBusy = false;
+		renderIdle.notify_all();
 	}
+}
 
-	float t = (ray.hit.z - z1) / (z2 - z1);
-	float s = (ray.hit.y - y1) / (y2 - y1);
-	color = (2 - s - t) * color + s * t * glm::vec3(1);
-	return color;
+//Brings the image up to date with the scene and camera, on the render thread
+void startRender()
+{
+	lock_guard<mutex> guard(renderMutex);
+	renderRequested = true;
+	renderWake.notify_one();
+}
+
+//Cancels the render in progress, if any, and waits until the render thread is idle
+void stopRender()
+{
+	unique_lock<mutex> lock(renderMutex);
+	renderRequested = false;
+	renderCancel = true;
+	renderIdle.wait(lock, [] { return !renderBusy; });
+}
+
+//Shows the tiles presented since the last call, on a timer in the GLUT thread
+void presentTimer(int)
+{
+	bool changed;
+	{
+		lock_guard<mutex> guard(frontMutex);
+		changed = frontChanged;
+	}
+	if (changed) glutPostRedisplay();
+	glutTimerFunc(PRESENT_INTERVAL, presentTimer, 0);
 }
 
 //---The main display module -----------------------------------------------------------
-// In a ray tracing application, it just displays the ray traced image by drawing
-// each cell as a quad.
+// In a ray tracing application, it just displays the ray traced image. It never
+// traces: the render thread does, presenting tiles to the front buffer as they
+// are done. The front buffer is uploaded into a texture when it has changed and
+// drawn as a single quad covering the window.
 //---------------------------------------------------------------------------------------
 void display()
 {
-	float xp, yp;  //grid point
-	float cellX = (XMAX-XMIN)/NUMDIV;  //cell width
-	float cellY = (YMAX-YMIN)/NUMDIV;  //cell height
-	float cells[8] = { -0.25, -0.25, 0.25, -0.25, -0.25, 0.25, 0.25, 0.25 };
-	glm::vec3 eye(0., 0., 0.);
+	{
+		lock_guard<mutex> guard(frontMutex);
+		if (frontChanged)
+		{
+			glBindTexture(GL_TEXTURE_2D, framebufferTex);
+			glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, NUMDIV, NUMDIV, GL_RGB, GL_FLOAT, &frontBuffer[0]);
+			frontChanged = false;
+		}
+	}
 
 	glClear(GL_COLOR_BUFFER_BIT);
     glMatrixMode(GL_MODELVIEW);
     glLoadIdentity();
 
-	glBegin(GL_QUADS);  //Each cell is a tiny quad.
+	glEnable(GL_TEXTURE_2D);
+	glBindTexture(GL_TEXTURE_2D, framebufferTex);
+	glBegin(GL_QUADS);
+		glTexCoord2f(0, 0); glVertex2f(XMIN, YMIN);
+		glTexCoord2f(1, 0); glVertex2f(XMAX, YMIN);
+		glTexCoord2f(1, 1); glVertex2f(XMAX, YMAX);
+		glTexCoord2f(0, 1); glVertex2f(XMIN, YMAX);
+	glEnd();
+	glDisable(GL_TEXTURE_2D);
+    glFlush();
+}
 
-	for(int i = 0; i < NUMDIV; i++)	//Scan every cell of the image plane
-	{
-		xp = XMIN + i*cellX;
-		for(int j = 0; j < NUMDIV; j++)
-		{ 
-			//extra for loop for anti aliasing
-			/*glm::vec3 cols[4];
-			for (int k = 0; k < 4; k++) {
-				yp = YMIN + j*cellY + cellY*cells[k+1];
-				float temp_xp = xp + cellX * cells[k];
-				glm::vec3 dir(temp_xp + 0.5*cellX, yp + 0.5*cellY, -EDIST);	//direction of the primary ray
-				Ray ray = Ray(eye, dir);
-				cols[k] = trace(ray, 1);
-			}
-			glm::vec3 col = (cols[0] + cols[1] + cols[2] + cols[3]) * 0.25f;*/
-			
-			// Uncomment below to not use supersampling
-			yp = YMIN + j*cellY;
-		    glm::vec3 dir(xp+0.5*cellX, yp+0.5*cellY, -EDIST);	//direction of the primary ray
-		    Ray ray = Ray(eye, dir);
-		    glm::vec3 col = trace (ray, 1); //Trace the primary ray and get the colour value*/
-
-			glColor3f(col.r, col.g, col.b);
-			glVertex2f(xp, yp);
-			glVertex2f(xp+cellX, yp);
-			glVertex2f(xp+cellX, yp+cellY);
-			glVertex2f(xp, yp+cellY);
-        }
-    }
 
-    glEnd();
-    glFlush();
+//Call after moving the camera, with the render thread stopped (stopRender()): traces the scene again
+void cameraChanged()
+{
+	framebufferValid = false;
+	startRender();
 }
 
+//Arrow keys move the camera sideways and up/down
+void special(int key, int, int)
+{
+	if (key != GLUT_KEY_LEFT && key != GLUT_KEY_RIGHT && key != GLUT_KEY_UP && key != GLUT_KEY_DOWN) return;
+	stopRender();
+	if (key == GLUT_KEY_LEFT) eye.x -= 1;
+	else if (key == GLUT_KEY_RIGHT) eye.x += 1;
+	else if (key == GLUT_KEY_UP) eye.y += 1;
+	else if (key == GLUT_KEY_DOWN) eye.y -= 1;
+	cameraChanged();
+}
 
-void octahedron(glm::vec3 c, float width, float height)
+//'p' switches between progressive previews and complete renders
+void keyboard(unsigned char key, int, int)
 {
-	float hh = height / 2;
-	float hw = width / 2;
-
-	Plane* plane1 = new Plane(glm::vec3(c.x, c.y, c.z),
-		glm::vec3(c.x, c.y+hh, c.z+hw),
-		glm::vec3(c.x-hw, c.y+hh, c.z));
-	plane1->setColor(glm::vec3(0, 1, 0));
-	plane1->setShininess(0.9);
-	sceneObjects.push_back(plane1);
-	Plane* plane2 = new Plane(glm::vec3(c.x, c.y, c.z),
-		glm::vec3(c.x+hw, c.y+hh, c.z),
-		glm::vec3(c.x, c.y+hh, c.z+hw));
-	plane2->setColor(glm::vec3(0, 1, 0));
-	plane2->setShininess(0.9);
-	sceneObjects.push_back(plane2);
-	Plane* plane3 = new Plane(glm::vec3(c.x, c.y, c.z),
-		glm::vec3(c.x, c.y+hh, c.z-hw),
-		glm::vec3(c.x+hw, c.y+hh, c.z));
-	plane3->setColor(glm::vec3(0, 1, 0));
-	plane3->setShininess(0.9);
-	sceneObjects.push_back(plane3);
-	Plane* plane4 = new Plane(glm::vec3(c.x, c.y, c.z),
-		glm::vec3(c.x-hw, c.y+hh, c.z),
-		glm::vec3(c.x, c.y+hh, c.z-hw));
-	plane4->setColor(glm::vec3(0, 1, 0));
-	plane4->setShininess(0.9);
-	sceneObjects.push_back(plane4);
-
-	Plane* plane5 = new Plane(glm::vec3(c.x, c.y+height, c.z),
-		glm::vec3(c.x-hw, c.y+hh, c.z),
-		glm::vec3(c.x, c.y + hh, c.z+hw));
-	plane5->setColor(glm::vec3(0, 1, 0));
-	plane5->setShininess(0.9);
-	sceneObjects.push_back(plane5);
-	Plane* plane6 = new Plane(glm::vec3(c.x, c.y+height, c.z),
-		glm::vec3(c.x, c.y + hh, c.z+hw),
-		glm::vec3(c.x+hw, c.y + hh, c.z));
-	plane6->setColor(glm::vec3(0, 1, 0));
-	plane6->setShininess(0.9);
-	sceneObjects.push_back(plane6);
-	Plane* plane7 = new Plane(glm::vec3(c.x, c.y+height, c.z),
-		glm::vec3(c.x+hw, c.y + hh, c.z),
-		glm::vec3(c.x, c.y + hh, c.z-hw));
-	plane7->setColor(glm::vec3(0, 1, 0));
-	plane7->setShininess(0.9);
-	sceneObjects.push_back(plane7);
-	Plane* plane8 = new Plane(glm::vec3(c.x, c.y + height, c.z),
-		glm::vec3(c.x, c.y + hh, c.z-hw),
-		glm::vec3(c.x-hw, c.y + hh, c.z));
-	plane8->setColor(glm::vec3(0, 1, 0));
-	plane8->setShininess(0.9);
-	sceneObjects.push_back(plane8);
+	if (key != 'p') return;
+	stopRender();
+	progressive = !progressive;
+	progress.running = false;
+	cameraChanged();
 }
 
-//---This function initializes the scene ------------------------------------------- 
-//   Specifically, it creates scene objects (spheres, planes, cones, cylinders etc)
-//     and add them to the list of scene objects.
-//   It also initializes the OpenGL orthographc projection matrix for drawing the
-//     the ray traced image.
+//---This function initializes the OpenGL state -------------------------------------
+//   Specifically, it initializes the OpenGL orthographc projection matrix and the
+//     texture for drawing the ray traced image, then builds the scene.
 //----------------------------------------------------------------------------------
-void initialize()
+bool initialize(const char* sceneName)
 {
 	glMatrixMode(GL_PROJECTION);
 	gluOrtho2D(XMIN, XMAX, YMIN, YMAX);
 
 	glClearColor(0, 0, 0, 1);
 
-	texture1 = TextureBMP("wall.bmp");
-	texture2 = TextureBMP("earth.bmp");
-
-	Plane* floorPlane = new Plane(glm::vec3(-50., -15, -40),                           
-		glm::vec3(50., -15, -40),							        
-		glm::vec3(50., -15, -150),								          
-		glm::vec3(-50., -15, -150));							
-	floorPlane->setSpecularity(false);
-	sceneObjects.push_back(floorPlane);
-
-	Plane* backPlane = new Plane(glm::vec3(-40., -16, -130),
-		glm::vec3(40., -16, -130),
-		glm::vec3(40., 30, -130),
-		glm::vec3(-40., 30, -130));
-	backPlane->setSpecularity(false);
-	backPlane->setColor(glm::vec3(0, 1, 0));
-	sceneObjects.push_back(backPlane);
-
-	//textured sphere
-	Sphere* earth = new Sphere(glm::vec3(-5.0, -1.0, -80.0), 3.5);
-	earth->setSpecularity(false);
-	sceneObjects.push_back(earth);
-
-	Cylinder* bottom = new Cylinder(glm::vec3(5, -8, -90), 4, 3.5);
-	bottom->setColor(glm::vec3(0, 0, 1));
-	bottom->setReflectivity(true, 0.4);
-	sceneObjects.push_back(bottom);
-
-	Cylinder* top = new Cylinder(glm::vec3(5, -4.5, -90), 2.5, 2.5);
-	top->setColor(glm::vec3(0, 0, 1));
-	top->setReflectivity(true, 0.4);
-	sceneObjects.push_back(top);
-
-	octahedron(glm::vec3(5, -2, -90), 3, 6);
-
-	Plane* table = new Plane(glm::vec3(-10, -8, -65),
-		glm::vec3(10, -8, -65),
-		glm::vec3(10, -8, -100),
-		glm::vec3(-10, -8, -100));
-	table->setColor(glm::vec3(0.55, 0.27, 0.08));
-	sceneObjects.push_back(table);
-
-	Cylinder* cylinder1 = new Cylinder(glm::vec3(-8, -15, -67), 0.5, 7);
-	cylinder1->setColor(glm::vec3(0.18, 0.3, 0.3));
-	sceneObjects.push_back(cylinder1);
-
-	Cylinder* cylinder2 = new Cylinder(glm::vec3(8, -15, -67), 0.5, 7);
-	cylinder2->setColor(glm::vec3(0.18, 0.3, 0.3));
-	sceneObjects.push_back(cylinder2);
-
-	Cylinder* cylinder3 = new Cylinder(glm::vec3(8, -15, -98), 0.5, 7);
-	cylinder3->setColor(glm::vec3(0.18, 0.3, 0.3));
-	sceneObjects.push_back(cylinder3);
-
-	Cylinder* cylinder4 = new Cylinder(glm::vec3(-8, -15, -98), 0.5, 7);
-	cylinder4->setColor(glm::vec3(0.18, 0.3, 0.3));
-	sceneObjects.push_back(cylinder4);
-
-	Cone* cone = new Cone(glm::vec3(-5, -8, -80), 3, 4);
-	cone->setColor(glm::vec3(0.8, 0, 0));
-	sceneObjects.push_back(cone);
-
-	//refractive sphere
-	Sphere* glassSphere = new Sphere(glm::vec3(7, -12, -60.0), 3.0);
-	glassSphere->setColor(glm::vec3(0, 0, 0));
-	glassSphere->setTransparency(true, 0.9);
-	glassSphere->setReflectivity(true, 0.05);
-	glassSphere->setRefractivity(true, 1, 1.05);
-	sceneObjects.push_back(glassSphere);
-
-	//transparent sphere
-	Sphere* sphere2 = new Sphere(glm::vec3(7, -5.5, -72.0), 2.5);
-	sphere2->setColor(glm::vec3(0.2, 0, 0));
-	sphere2->setTransparency(true, 0.8);
-	sphere2->setReflectivity(true, 0.05);
-	sceneObjects.push_back(sphere2);
-
-	//reflective sphere
-	Sphere *sphere1 = new Sphere(glm::vec3(-9, -13.5, -62.0), 1.5);
-	sphere1->setColor(glm::vec3(0, 1, 0));  
-	sphere1->setReflectivity(true, 0.8);
-	sceneObjects.push_back(sphere1);
+	//One texel per cell; every render is uploaded into it with a single call
+	glGenTextures(1, &framebufferTex);
+	glBindTexture(GL_TEXTURE_2D, framebufferTex);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP);
+	glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_REPLACE);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB8, NUMDIV, NUMDIV, 0, GL_RGB, GL_FLOAT, NULL);
+
+	return initializeScene(sceneName);
 }
 
+//---This function initializes the scene ------------------------------------------- 
+//   Specifically, it loads the scene file, creates its scene objects (spheres, planes,
+//     cones, cylinders etc) and takes the camera, lights and fog settings from it.
+//     It makes no OpenGL calls, so that it can also be used without a window.
+//----------------------------------------------------------------------------------
+bool initializeScene(const char* filename)
+{
+	if (!sceneFile.load(filename)) return false;
+
+	//The textures load on background threads while the objects and the BVH are built
+	vector<future<const Texture*>> pendingTextures;
+	for (int i = 0; i < sceneFile.getNumTextures(); i++)
+		pendingTextures.push_back(textureRegistry.loadAsync(sceneFile.getTexturePath(i)));
+
+	const CameraRecord& camera = sceneFile.getCamera();
+	eye = glm::vec3(camera.eye[0], camera.eye[1], camera.eye[2]);
+	viewDist = camera.distance;
+	viewWidth = camera.width;
+	viewHeight = camera.height;
+
+	const SettingsRecord& settings = sceneFile.getSettings();
+	shading.background = glm::vec3(settings.background[0], settings.background[1], settings.background[2]);
+	shading.fog = (settings.fog != 0);
+	for (int k = 0; k < 2; k++)
+	{
+		shading.fogZ[k] = settings.fogZ[k];
+		shading.fogY[k] = settings.fogY[k];
+	}
+	shading.maxSteps = settings.maxDepth;
+	shading.minWeight = settings.minWeight;
+	shading.roulette = (settings.roulette != 0);
+	aaLevels = settings.aaLevels;
+	aaThreshold = settings.aaThreshold;
+	progressive = (settings.progressive != 0);
+	progressiveTime = settings.progressiveTime;
+	progressiveSamples = settings.progressiveSamples;
+
+	sceneFile.createLights(lights);
+	if (!sceneFile.createObjects(sceneObjects)) return false;
+	scene.build(sceneObjects);
+	packetTracer.build(scene);
+	animation.build(sceneFile, sceneObjects);
+
+	textures.resize(pendingTextures.size());
+	for (size_t i = 0; i < pendingTextures.size(); i++) textures[i] = pendingTextures[i].get();
+	shading.scene = &scene;
+	shading.packetTracer = &packetTracer;
+	shading.textures = &textures;
+	shading.lights = &lights;
+	return true;
+}
+
+
+//---Headless mode -----------------------------------------------------------------
+//   Builds the scene, renders it once at the requested size and writes the image,
+//     without creating a window or an OpenGL context.
+//----------------------------------------------------------------------------------
+int renderToFile(const char* sceneName, const char* filename, int width, int height)
+{
+	imageWidth = width;
+	imageHeight = height;
+	if (!initializeScene(sceneName)) return 1;
+
+	auto start = chrono::steady_clock::now();
+	render();
+	double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+	cout << "Rendered " << width << " x " << height << " in " << seconds << " s on "
+		<< renderer.getNumThreads() << " threads." << endl;
+
+	if (!writeImage(filename, imageWidth, imageHeight, framebuffer)) return 1;
+	cout << "Image " << filename << "  written." << endl;
+	return 0;
+}
 
+//---Animation -----------------------------------------------------------------------
+//   Renders frames first to last of the scene file's keyframes in one run, writing
+//     frame n to the output name with n (4 digits) before the extension. Between
+//     frames the scene is refitted rather than rebuilt, and if the camera has not
+//     moved only the cells the moved instances and lights can affect are traced again.
+//----------------------------------------------------------------------------------
+int renderAnimation(const char* sceneName, const char* filename, int width, int height)
+{
+	imageWidth = width;
+	imageHeight = height;
+	if (!initializeScene(sceneName)) return 1;
+
+	const SettingsRecord& settings = sceneFile.getSettings();
+	string name(filename);
+	size_t dot = name.find_last_of('.');
+	if (dot == string::npos || name.find_last_of("/\\") > dot) dot = name.size();
+	vector<int> movedObjects, movedLights;
+	vector<AABB> movedBoxes;
+	auto start = chrono::steady_clock::now();
+	int rebuilds = 0;
+	for (int frame = settings.frames[0]; frame <= settings.frames[1]; frame++)
+	{
+		glm::vec3 oldEye = eye;
+		animation.apply(frame, eye, lights, movedObjects, movedLights);
+		if (eye != oldEye) framebufferValid = false;
+		movedBoxes.resize(movedObjects.size());
+		for (size_t i = 0; i < movedObjects.size(); i++) movedBoxes[i] = sceneObjects[movedObjects[i]]->bounds();
+		dirtyTracker.objectsChanged(movedObjects, movedBoxes, lights);
+		for (size_t i = 0; i < movedLights.size(); i++) dirtyTracker.lightChanged(movedLights[i], lights[movedLights[i]]);
+		if (!movedObjects.empty())
+		{
+			if (scene.refit(sceneObjects)) rebuilds++;
+			packetTracer.build(scene);
+		}
+		render();
+
+		char number[16];
+		snprintf(number, sizeof(number), "%04d", frame);
+		string frameName = name.substr(0, dot) + number + name.substr(dot);
+		if (!writeImage(frameName.c_str(), imageWidth, imageHeight, framebuffer)) return 1;
+	}
+	double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+	cout << "Rendered frames " << settings.frames[0] << " to " << settings.frames[1] << " at " << width << " x " << height
+		<< " in " << seconds << " s (" << rebuilds << " BVH rebuilds)." << endl;
+	return 0;
+}
+
+//Usage:  RayTracer [scene.txt]         opens the window
+//        RayTracer [scene.txt] -o image.png [-w width] [-h height]
+//                                        renders headless to a .ppm, .png, .bmp or .pfm file
+//        RayTracer [scene.txt] -a frame.png [-w width] [-h height]
+//                                        renders the scene's animation headless, to frame0000.png...
+//        RayTracer [scene.txt] -b scene.rtscene
+//                                        saves the parsed scene as a binary scene file,
+//                                        which loads without parsing in place of scene.txt
 int main(int argc, char *argv[]) {
+	const char* sceneName = "scene.txt";
+	const char* output = NULL;
+	const char* animationOutput = NULL;
+	const char* binaryOutput = NULL;
+	int width = NUMDIV, height = NUMDIV;
+	for (int i = 1; i < argc; i++)
+	{
+		if (argv[i][0] != '-') sceneName = argv[i];
+		else if (i + 1 >= argc) break;
+		else if (strcmp(argv[i], "-o") == 0) output = argv[++i];
+		else if (strcmp(argv[i], "-a") == 0) animationOutput = argv[++i];
+		else if (strcmp(argv[i], "-b") == 0) binaryOutput = argv[++i];
+		else if (strcmp(argv[i], "-w") == 0) width = atoi(argv[++i]);
+		else if (strcmp(argv[i], "-h") == 0) height = atoi(argv[++i]);
+		else i++;
+	}
+	if (binaryOutput != NULL)
+	{
+		if (!sceneFile.load(sceneName) || !sceneFile.saveBinary(binaryOutput)) return 1;
+		cout << "Scene file " << binaryOutput << "  written." << endl;
+		return 0;
+	}
+	if (output != NULL || animationOutput != NULL)
+	{
+		if (width <= 0 || height <= 0)
+		{
+			cerr << "Invalid image size " << width << " x " << height << endl;
+			return 1;
+		}
+		if (animationOutput != NULL) return renderAnimation(sceneName, animationOutput, width, height);
+		return renderToFile(sceneName, output, width, height);
+	}
+
     glutInit(&argc, argv);
     glutInitDisplayMode(GLUT_SINGLE | GLUT_RGB );
     glutInitWindowSize(500, 500);
@@ -353,8 +806,23 @@ int main(int argc, char *argv[]) {
     glutCreateWindow("Raytracing");
 
     glutDisplayFunc(display);
-    initialize();
-
+    glutSpecialFunc(special);
+    glutKeyboardFunc(keyboard);
+    glutSetOption(GLUT_ACTION_ON_WINDOW_CLOSE, GLUT_ACTION_GLUTMAINLOOP_RETURNS);
+    if (!initialize(sceneName)) return 1;
+
+    backgroundRender = true;
+    renderThread = thread(renderLoop);
+    startRender();
+    glutTimerFunc(PRESENT_INTERVAL, presentTimer, 0);
     glutMainLoop();
+
+    stopRender();
+    {
+        lock_guard<mutex> guard(renderMutex);
+        renderQuit = true;
+    }
+    renderWake.notify_one();
+    renderThread.join();
     return 0;
 }
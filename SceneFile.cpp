@@ -0,0 +1,757 @@
+/*----------------------------------------------------------
+* COSC363  Ray Tracer
+*
+*  The scene file class
+*  Text parser, binary scene cache and object creation.
+-------------------------------------------------------------*/
+
+#include "SceneFile.h"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <map>
+#include <cstring>
+#include <cstddef>
+#include <cmath>
+
+/**
+* Header of the binary scene format, followed by the records as they are in memory:
+*   Material[numMaterials], int32[numTextures], LightRecord[numLights],
+*   ObjectRecord[numObjects], KeyRecord[numKeys], char[stringBytes]
+* The record sizes are stored so that a cache written by a build with a different
+* layout is rejected rather than misread; the text file can always be used instead.
+*/
+struct SceneFileHeader
+{
+	char magic[8];
+	uint32_t recordSizes[5];
+	int32_t numMaterials;
+	int32_t numTextures;
+	int32_t numLights;
+	int32_t numObjects;
+	int32_t numKeys;
+	int32_t stringBytes;
+	CameraRecord camera;
+	SettingsRecord settings;
+};
+
+static const char SCENE_MAGIC[8] = { 'R', 'T', 'S', 'C', 'E', 'N', 'E', '1' };
+static const uint32_t RECORD_SIZES[5] = { sizeof(Material), sizeof(LightRecord), sizeof(ObjectRecord), sizeof(KeyRecord), sizeof(SceneFileHeader) };
+
+static_assert(sizeof(Material) % 4 == 0 && sizeof(SceneFileHeader) % 4 == 0, "scene records must keep 4-byte alignment");
+
+//Largest settings a scene may ask for: they bound the work and memory of a render
+const int MAX_RAY_DEPTH = 64;				//Steps of a chain of rays
+const int MAX_AA_LEVELS = 8;				//Each level can split a square into 4
+const int MAX_FRAMES = 10000;				//Frames of an animation
+const int MAX_PROGRESSIVE_SAMPLES = 65536;	//Samples per cell of a progressive preview
+const int MAX_LIGHT_SAMPLES = 1024;			//Shadow rays per hit of an area light
+
+//Reads a scene from a text file or from a binary scene file, whichever it is
+bool SceneFile::load(const char* filename)
+{
+	char magic[8] = { 0 };
+	std::ifstream file(filename, std::ios::in | std::ios::binary);
+	if (!file)
+	{
+		std::cout << "*** Error opening scene file: " << filename << std::endl;
+		return false;
+	}
+	file.read(magic, 8);
+	file.close();
+	if (memcmp(magic, SCENE_MAGIC, 8) == 0) return loadBinary(filename);
+	return loadText(filename);
+}
+
+//Points the records in use at the vectors filled by the text parser
+void SceneFile::useVectors()
+{
+	materials_ = materialData_.empty() ? nullptr : &materialData_[0];
+	textures_ = textureData_.empty() ? nullptr : &textureData_[0];
+	lights_ = lightData_.empty() ? nullptr : &lightData_[0];
+	objects_ = objectData_.empty() ? nullptr : &objectData_[0];
+	keys_ = keyData_.empty() ? nullptr : &keyData_[0];
+	strings_ = stringData_.empty() ? nullptr : &stringData_[0];
+	camera_ = &cameraData_;
+	settings_ = &settingsData_;
+	numMaterials_ = materialData_.size();
+	numTextures_ = textureData_.size();
+	numLights_ = lightData_.size();
+	numObjects_ = objectData_.size();
+	numKeys_ = keyData_.size();
+	stringBytes_ = stringData_.size();
+}
+
+//Reads n numbers into v; returns false if there are fewer
+static bool readFloats(std::istringstream& in, float* v, int n)
+{
+	for (int i = 0; i < n; i++)
+	{
+		if (!(in >> v[i])) return false;
+	}
+	return true;
+}
+
+//Reads the geometry of an object statement (everything after the material) into obj
+static bool readGeometry(const std::string& keyword, std::istringstream& in, ObjectRecord& obj, std::vector<char>& strings)
+{
+	if (keyword == "sphere") { obj.type = OBJECT_SPHERE; return readFloats(in, obj.p, 4); }
+	if (keyword == "plane") { obj.type = OBJECT_PLANE; obj.count = 4; return readFloats(in, obj.p, 12); }
+	if (keyword == "triangle") { obj.type = OBJECT_PLANE; obj.count = 3; return readFloats(in, obj.p, 9); }
+	if (keyword == "cylinder") { obj.type = OBJECT_CYLINDER; return readFloats(in, obj.p, 5); }
+	if (keyword == "cone") { obj.type = OBJECT_CONE; return readFloats(in, obj.p, 5); }
+	if (keyword == "octahedron") { obj.type = OBJECT_OCTAHEDRON; return readFloats(in, obj.p, 5); }
+	if (keyword == "mesh")
+	{
+		std::string path;
+		obj.type = OBJECT_MESH;
+		if (!(in >> path)) return false;
+		obj.path = strings.size();
+		strings.insert(strings.end(), path.begin(), path.end());
+		strings.push_back('\0');
+		return true;
+	}
+	return false;
+}
+
+//Reads an instance's transform operations, each applied after the ones before, into its record
+static bool readTransform(std::istringstream& in, ObjectRecord& obj)
+{
+	glm::mat4 m(1);
+	std::string op;
+	while (in >> op)
+	{
+		glm::mat4 step(1);
+		float v[4];
+		if (op == "translate")
+		{
+			if (!readFloats(in, v, 3)) return false;
+			step[3] = glm::vec4(v[0], v[1], v[2], 1);
+		}
+		else if (op == "scale")
+		{
+			if (!readFloats(in, v, 3) || v[0] == 0 || v[1] == 0 || v[2] == 0) return false;
+			step[0][0] = v[0];
+			step[1][1] = v[1];
+			step[2][2] = v[2];
+		}
+		else if (op == "rotate")
+		{
+			if (!readFloats(in, v, 4) || glm::length(glm::vec3(v[1], v[2], v[3])) == 0) return false;
+			step = Instance::rotation(v[0], glm::vec3(v[1], v[2], v[3]));
+		}
+		else return false;
+		m = step * m;
+	}
+	for (int row = 0; row < 3; row++)
+		for (int col = 0; col < 4; col++) obj.p[row * 4 + col] = m[col][row];
+	return true;
+}
+
+/**
+* Parses the text format. Each line is one statement; '#' starts a comment.
+*   camera     eye_x eye_y eye_z  distance  width height
+*   background r g b
+*   fog        z1 z2 y1 y2
+*   depth      max_depth
+*   minweight  w  roulette|cutoff
+*   antialias  levels threshold
+*   frames     first last
+*   progressive seconds samples
+*   light      point x y z  [range r] [color r g b]
+*   light      spot  x y z  dir_x dir_y dir_z  cutoff_degrees  [range r] [color r g b]
+*   light      directional  dir_x dir_y dir_z  [color r g b]
+*   light      sphere  x y z  radius  [samples n] [range r] [color r g b]
+*   light      rect  x y z  u_x u_y u_z  v_x v_y v_z  [samples n] [range r] [color r g b]
+*   texture    name file.bmp
+*   material   name [color r g b] [reflect c] [reflectfront c] [refract c index]
+*                   [transparent c] [specular on|off] [shininess s]
+*                   [texture name] [filter nearest|bilinear|trilinear]
+*                   [checker r g b] [repeat nu nv]
+*   sphere     material  cx cy cz  radius
+*   plane      material  4 vertices (x y z each)
+*   triangle   material  3 vertices (x y z each)
+*   cylinder   material  cx cy cz  radius height
+*   cone       material  cx cy cz  radius height
+*   mesh       material  file.obj | file.rtmesh
+*   octahedron material  bottom_x bottom_y bottom_z  width height
+*   prototype  name  object   (any of the object statements above, without the material)
+*   instance   material  prototype  [scale sx sy sz] [rotate degrees ax ay az] [translate x y z]
+*   animate    camera  frame  x y z
+*   animate    light n  frame  x y z
+*   animate    instance n  frame  [translate x y z] [rotate degrees ax ay az] [scale sx sy sz]
+* Materials and textures must be declared before they are used. 'reflectfront'
+* only reflects where the surface faces +z. A texture or checker pattern is laid
+* over the UVs each object supplies (see SceneObject::texcoord()), repeated
+* nu x nv times; the checker alternates between color and the colour given.
+* Textures are filtered trilinearly unless the material says otherwise.
+* A light with a range lights nothing beyond that distance; without one it
+* reaches the whole scene, undimmed. Sphere and rectangle lights cast soft
+* shadows, with up to n shadow rays per hit (16 by default). A rectangle is
+* centred on x y z with sides u and v, and lights the side u x v points to.
+* A prototype is not part of the scene itself: each instance of it places a copy,
+* sharing its geometry, transformed by the instance's operations in the order
+* given (e.g. rotating a cylinder about x or z lays it on its side).
+* 'animate' sets a keyframe for the camera's eye, the position of the nth light
+* or the nth instance (both counted from 0 in the order declared, which must be
+* before the key). Between keys the values are interpolated linearly; before the
+* first and after the last they hold. An instance key moves the prototype in its
+* own space: scaled, then rotated, then translated, before the instance's own
+* operations. Keys are only used when rendering the frames first to last.
+* 'progressive' starts the window in progressive mode (toggled with 'p'): quick
+* coarse previews, refined until they have the given samples per cell or have
+* accumulated samples for the given seconds.
+* The settings are limited to a depth of 64, 8 anti-aliasing levels, 10000
+* frames, 65536 progressive samples and 1024 samples per light.
+*/
+bool SceneFile::loadText(const char* filename)
+{
+	std::ifstream file(filename);
+	if (!file)
+	{
+		std::cout << "*** Error opening scene file: " << filename << std::endl;
+		return false;
+	}
+
+	materialData_.clear();
+	textureData_.clear();
+	lightData_.clear();
+	objectData_.clear();
+	stringData_.clear();
+	cameraData_ = CameraRecord();
+	settingsData_ = SettingsRecord();
+	file_.close();
+
+	keyData_.clear();
+	std::map<std::string, int> materialIndex, textureIndex, prototypeIndex;
+	std::vector<int> instanceRecords;
+	std::string line;
+	int lineNumber = 0;
+	bool ok = true;
+	while (ok && getline(file, line))
+	{
+		lineNumber++;
+		size_t comment = line.find('#');
+		if (comment != std::string::npos) line.erase(comment);
+		std::istringstream in(line);
+		std::string keyword;
+		if (!(in >> keyword)) continue;
+
+		if (keyword == "camera")
+		{
+			ok = readFloats(in, cameraData_.eye, 3) && readFloats(in, &cameraData_.distance, 1)
+				&& readFloats(in, &cameraData_.width, 1) && readFloats(in, &cameraData_.height, 1);
+		}
+		else if (keyword == "background")
+		{
+			ok = readFloats(in, settingsData_.background, 3);
+		}
+		else if (keyword == "depth")
+		{
+			float depth;
+			ok = readFloats(in, &depth, 1) && depth >= 1 && depth <= MAX_RAY_DEPTH;
+			settingsData_.maxDepth = (int)depth;
+		}
+		else if (keyword == "antialias")
+		{
+			float levels;
+			ok = readFloats(in, &levels, 1) && readFloats(in, &settingsData_.aaThreshold, 1) && levels >= 0 && levels <= MAX_AA_LEVELS;
+			settingsData_.aaLevels = (int)levels;
+		}
+		else if (keyword == "progressive")
+		{
+			float samples;
+			ok = readFloats(in, &settingsData_.progressiveTime, 1) && readFloats(in, &samples, 1)
+				&& settingsData_.progressiveTime >= 0 && samples >= 1 && samples <= MAX_PROGRESSIVE_SAMPLES;
+			settingsData_.progressiveSamples = (int)samples;
+			settingsData_.progressive = 1;
+		}
+		else if (keyword == "frames")
+		{
+			float frames[2];
+			ok = readFloats(in, frames, 2) && frames[0] <= frames[1] && frames[1] - frames[0] < MAX_FRAMES;
+			settingsData_.frames[0] = (int)frames[0];
+			settingsData_.frames[1] = (int)frames[1];
+		}
+		else if (keyword == "minweight")
+		{
+			std::string mode;
+			ok = readFloats(in, &settingsData_.minWeight, 1) && (in >> mode) && (mode == "roulette" || mode == "cutoff");
+			settingsData_.roulette = (mode == "roulette");
+		}
+		else if (keyword == "fog")
+		{
+			ok = readFloats(in, settingsData_.fogZ, 2) && readFloats(in, settingsData_.fogY, 2);
+			settingsData_.fog = 1;
+		}
+		else if (keyword == "light")
+		{
+			LightRecord light;
+			std::string type;
+			in >> type;
+			if (type == "point")
+			{
+				light.type = LIGHT_POINT;
+				ok = readFloats(in, light.position, 3);
+			}
+			else if (type == "spot")
+			{
+				light.type = LIGHT_SPOT;
+				ok = readFloats(in, light.position, 3) && readFloats(in, light.direction, 3) && readFloats(in, &light.cutoff, 1);
+			}
+			else if (type == "directional")
+			{
+				light.type = LIGHT_DIRECTIONAL;
+				ok = readFloats(in, light.direction, 3);
+			}
+			else if (type == "sphere")
+			{
+				light.type = LIGHT_SPHERE;
+				ok = readFloats(in, light.position, 3) && readFloats(in, &light.radius, 1) && light.radius > 0;
+			}
+			else if (type == "rect")
+			{
+				light.type = LIGHT_RECT;
+				ok = readFloats(in, light.position, 3) && readFloats(in, light.edgeU, 3) && readFloats(in, light.edgeV, 3);
+			}
+			else ok = false;
+			std::string key;
+			while (ok && in >> key)
+			{
+				if (key == "range") ok = readFloats(in, &light.range, 1) && light.range >= 0 && light.type != LIGHT_DIRECTIONAL;
+				else if (key == "color") ok = readFloats(in, light.color, 3);
+				else if (key == "samples")
+				{
+					float samples;
+					ok = readFloats(in, &samples, 1) && samples >= 1 && samples <= MAX_LIGHT_SAMPLES && (light.type == LIGHT_SPHERE || light.type == LIGHT_RECT);
+					light.samples = (int)samples;
+				}
+				else ok = false;
+			}
+			lightData_.push_back(light);
+		}
+		else if (keyword == "texture")
+		{
+			std::string name, path;
+			ok = (bool)(in >> name >> path);
+			textureIndex[name] = textureData_.size();
+			textureData_.push_back(stringData_.size());
+			stringData_.insert(stringData_.end(), path.begin(), path.end());
+			stringData_.push_back('\0');
+		}
+		else if (keyword == "material")
+		{
+			Material m;
+			std::string name, key;
+			ok = (bool)(in >> name);
+			while (ok && in >> key)
+			{
+				if (key == "color") ok = readFloats(in, &m.color.r, 1) && readFloats(in, &m.color.g, 1) && readFloats(in, &m.color.b, 1);
+				else if (key == "reflect") { m.refl = true; ok = readFloats(in, &m.reflc, 1); }
+				else if (key == "reflectfront") { m.refl = m.reflfront = true; ok = readFloats(in, &m.reflc, 1); }
+				else if (key == "refract") { m.refr = true; ok = readFloats(in, &m.refrc, 1) && readFloats(in, &m.refri, 1); }
+				else if (key == "transparent") { m.tran = true; ok = readFloats(in, &m.tranc, 1); }
+				else if (key == "shininess") ok = readFloats(in, &m.shin, 1);
+				else if (key == "filter")
+				{
+					std::string mode;
+					in >> mode;
+					ok = (mode == "nearest" || mode == "bilinear" || mode == "trilinear");
+					m.filter = (mode == "nearest") ? FILTER_NEAREST : (mode == "bilinear") ? FILTER_BILINEAR : FILTER_TRILINEAR;
+				}
+				else if (key == "repeat") ok = readFloats(in, &m.repeatU, 1) && readFloats(in, &m.repeatV, 1);
+				else if (key == "checker")
+				{
+					m.mapping = MAP_CHECKER;
+					ok = readFloats(in, &m.color2.r, 1) && readFloats(in, &m.color2.g, 1) && readFloats(in, &m.color2.b, 1);
+				}
+				else if (key == "texture")
+				{
+					std::string textureName;
+					in >> textureName;
+					ok = (textureIndex.count(textureName) > 0);
+					if (ok)
+					{
+						m.mapping = MAP_TEXTURE;
+						m.texture = textureIndex[textureName];
+					}
+				}
+				else if (key == "specular")
+				{
+					std::string flag;
+					in >> flag;
+					ok = (flag == "on" || flag == "off");
+					m.spec = (flag == "on");
+				}
+				else ok = false;
+			}
+			materialIndex[name] = materialData_.size();
+			materialData_.push_back(m);
+		}
+		else if (keyword == "sphere" || keyword == "plane" || keyword == "triangle" || keyword == "cylinder"
+			|| keyword == "cone" || keyword == "octahedron" || keyword == "mesh")
+		{
+			ObjectRecord obj;
+			std::string materialName;
+			in >> materialName;
+			if (materialIndex.count(materialName) == 0)
+			{
+				std::cout << "*** Unknown material '" << materialName << "' in " << filename << " line " << lineNumber << std::endl;
+				return false;
+			}
+			obj.material = materialIndex[materialName];
+			ok = readGeometry(keyword, in, obj, stringData_);
+			objectData_.push_back(obj);
+		}
+		else if (keyword == "prototype")
+		{
+			ObjectRecord obj;
+			std::string name, type;
+			ok = (bool)(in >> name >> type) && readGeometry(type, in, obj, stringData_);
+			obj.material = -1;
+			prototypeIndex[name] = objectData_.size();
+			objectData_.push_back(obj);
+		}
+		else if (keyword == "instance")
+		{
+			ObjectRecord obj;
+			std::string materialName, prototypeName;
+			in >> materialName >> prototypeName;
+			if (materialIndex.count(materialName) == 0 || prototypeIndex.count(prototypeName) == 0)
+			{
+				std::cout << "*** Unknown material or prototype in " << filename << " line " << lineNumber << std::endl;
+				return false;
+			}
+			obj.type = OBJECT_INSTANCE;
+			obj.material = materialIndex[materialName];
+			obj.count = prototypeIndex[prototypeName];
+			ok = readTransform(in, obj);
+			instanceRecords.push_back(objectData_.size());
+			objectData_.push_back(obj);
+		}
+		else if (keyword == "animate")
+		{
+			KeyRecord key;
+			std::string target;
+			float index = 0;
+			in >> target;
+			if (target == "camera") key.target = KEY_CAMERA;
+			else if (target == "light") key.target = KEY_LIGHT;
+			else if (target == "instance") key.target = KEY_INSTANCE;
+			else ok = false;
+			if (ok && key.target != KEY_CAMERA)
+			{
+				int count = (key.target == KEY_LIGHT) ? lightData_.size() : instanceRecords.size();
+				ok = readFloats(in, &index, 1) && index >= 0 && index < count;
+			}
+			ok = ok && readFloats(in, &key.frame, 1);
+			if (ok && key.target == KEY_INSTANCE)
+			{
+				key.index = instanceRecords[(int)index];
+				std::string op;
+				while (ok && in >> op)
+				{
+					if (op == "translate") ok = readFloats(in, key.translate, 3);
+					else if (op == "rotate") ok = readFloats(in, key.rotate, 4);
+					else if (op == "scale") ok = readFloats(in, key.scale, 3) && key.scale[0] != 0 && key.scale[1] != 0 && key.scale[2] != 0;
+					else ok = false;
+				}
+			}
+			else if (ok)
+			{
+				key.index = (int)index;
+				ok = readFloats(in, key.translate, 3);
+			}
+			keyData_.push_back(key);
+		}
+		else ok = false;
+	}
+
+	if (!ok)
+	{
+		std::cout << "*** Syntax error in " << filename << " line " << lineNumber << ": " << line << std::endl;
+		return false;
+	}
+	useVectors();
+	return true;
+}
+
+//Maps a scene written by saveBinary() and uses its records in place
+bool SceneFile::loadBinary(const char* filename)
+{
+	if (!file_.open(filename))
+	{
+		std::cout << "*** Error opening scene file: " << filename << std::endl;
+		return false;
+	}
+
+	SceneFileHeader header = SceneFileHeader();
+	if (file_.size() >= sizeof(header)) memcpy(&header, file_.data(), sizeof(header));
+	size_t expected = sizeof(header) + sizeof(Material) * (size_t)header.numMaterials + 4 * (size_t)header.numTextures
+		+ sizeof(LightRecord) * (size_t)header.numLights + sizeof(ObjectRecord) * (size_t)header.numObjects
+		+ sizeof(KeyRecord) * (size_t)header.numKeys + header.stringBytes;
+	if (file_.size() < sizeof(header) || memcmp(header.recordSizes, RECORD_SIZES, sizeof(RECORD_SIZES)) != 0
+		|| header.numMaterials < 0 || header.numTextures < 0 || header.numLights < 0 || header.numObjects < 0
+		|| header.numKeys < 0 || header.stringBytes < 0 || file_.size() < expected)
+	{
+		std::cout << "*** Scene file " << filename << " was written by an incompatible version" << std::endl;
+		file_.close();
+		return false;
+	}
+
+	const char* data = file_.data();
+	camera_ = (const CameraRecord*)(data + offsetof(SceneFileHeader, camera));
+	settings_ = (const SettingsRecord*)(data + offsetof(SceneFileHeader, settings));
+	data += sizeof(header);
+	materials_ = (const Material*)data;
+	data += sizeof(Material) * header.numMaterials;
+	textures_ = (const int32_t*)data;
+	data += 4 * header.numTextures;
+	lights_ = (const LightRecord*)data;
+	data += sizeof(LightRecord) * header.numLights;
+	objects_ = (const ObjectRecord*)data;
+	data += sizeof(ObjectRecord) * header.numObjects;
+	keys_ = (const KeyRecord*)data;
+	data += sizeof(KeyRecord) * header.numKeys;
+	strings_ = data;
+	numMaterials_ = header.numMaterials;
+	numTextures_ = header.numTextures;
+	numLights_ = header.numLights;
+	numObjects_ = header.numObjects;
+	numKeys_ = header.numKeys;
+	stringBytes_ = header.stringBytes;
+
+	//File names are read up to their '\0', so they must start inside the string table and it must end with one
+	bool stringsValid = (stringBytes_ == 0 || strings_[stringBytes_ - 1] == '\0');
+	for (int i = 0; i < numTextures_; i++)
+		stringsValid = stringsValid && textures_[i] >= 0 && textures_[i] < stringBytes_;
+	for (int i = 0; i < numObjects_; i++)
+		if (objects_[i].type == OBJECT_MESH) stringsValid = stringsValid && objects_[i].path >= 0 && objects_[i].path < stringBytes_;
+	if (!stringsValid)
+	{
+		std::cout << "*** Scene file " << filename << " has an invalid file name" << std::endl;
+		file_.close();
+		return false;
+	}
+
+	//The settings size loops and buffers of the render, so they are held to the text parser's limits
+	const SettingsRecord& s = *settings_;
+	if (s.maxDepth < 1 || s.maxDepth > MAX_RAY_DEPTH || s.aaLevels < 0 || s.aaLevels > MAX_AA_LEVELS
+		|| s.frames[0] > s.frames[1] || (long long)s.frames[1] - s.frames[0] >= MAX_FRAMES
+		|| !(s.progressiveTime >= 0) || s.progressiveSamples < 1 || s.progressiveSamples > MAX_PROGRESSIVE_SAMPLES)
+	{
+		std::cout << "*** Scene file " << filename << " has invalid settings" << std::endl;
+		file_.close();
+		return false;
+	}
+
+	//Lights are counted by position, so one that could not be created would shift the others
+	for (int i = 0; i < numLights_; i++)
+	{
+		const LightRecord& light = lights_[i];
+		if (light.type < LIGHT_POINT || light.type > LIGHT_RECT || light.samples < 1 || light.samples > MAX_LIGHT_SAMPLES)
+		{
+			std::cout << "*** Scene file " << filename << " has an invalid light" << std::endl;
+			file_.close();
+			return false;
+		}
+	}
+
+	//Objects are created by type, and instances must refer to a prototype before them
+	for (int i = 0; i < numObjects_; i++)
+	{
+		const ObjectRecord& obj = objects_[i];
+		bool valid = obj.type >= OBJECT_SPHERE && obj.type <= OBJECT_INSTANCE && obj.material >= -1 && obj.material < numMaterials_;
+		if (obj.type == OBJECT_INSTANCE)
+			valid = valid && obj.material >= 0 && obj.count >= 0 && obj.count < i && objects_[obj.count].material == -1;
+		if (!valid)
+		{
+			std::cout << "*** Scene file " << filename << " has an invalid object" << std::endl;
+			file_.close();
+			return false;
+		}
+	}
+
+	//Keys must refer to a light or an instance
+	for (int i = 0; i < numKeys_; i++)
+	{
+		const KeyRecord& key = keys_[i];
+		bool valid = key.target >= KEY_CAMERA && key.target <= KEY_INSTANCE;
+		if (key.target == KEY_LIGHT) valid = key.index >= 0 && key.index < numLights_;
+		if (key.target == KEY_INSTANCE)
+			valid = key.index >= 0 && key.index < numObjects_ && objects_[key.index].type == OBJECT_INSTANCE && objects_[key.index].material >= 0;
+		if (!valid)
+		{
+			std::cout << "*** Scene file " << filename << " has an invalid keyframe" << std::endl;
+			file_.close();
+			return false;
+		}
+	}
+
+	//The shading functions are looked up by these fields, so they must be in range
+	for (int i = 0; i < numMaterials_; i++)
+	{
+		const Material& m = materials_[i];
+		if (m.mapping < 0 || m.mapping >= NUM_MAPPINGS || (m.mapping == MAP_TEXTURE && (m.texture < 0 || m.texture >= numTextures_ || m.filter < 0 || m.filter >= NUM_FILTERS)))
+		{
+			std::cout << "*** Scene file " << filename << " has an invalid material" << std::endl;
+			file_.close();
+			return false;
+		}
+	}
+	return true;
+}
+
+//Writes the scene in the binary form read by load()
+bool SceneFile::saveBinary(const char* filename)
+{
+	std::ofstream file(filename, std::ios::out | std::ios::binary);
+	if (!file)
+	{
+		std::cout << "*** Error creating scene file: " << filename << std::endl;
+		return false;
+	}
+
+	SceneFileHeader header = SceneFileHeader();
+	memcpy(header.magic, SCENE_MAGIC, sizeof(SCENE_MAGIC));
+	memcpy(header.recordSizes, RECORD_SIZES, sizeof(RECORD_SIZES));
+	header.numMaterials = numMaterials_;
+	header.numTextures = numTextures_;
+	header.numLights = numLights_;
+	header.numObjects = numObjects_;
+	header.numKeys = numKeys_;
+	header.stringBytes = stringBytes_;
+	header.camera = *camera_;
+	header.settings = *settings_;
+	file.write((const char*)&header, sizeof(header));
+	file.write((const char*)materials_, sizeof(Material) * numMaterials_);
+	file.write((const char*)textures_, 4 * numTextures_);
+	file.write((const char*)lights_, sizeof(LightRecord) * numLights_);
+	file.write((const char*)objects_, sizeof(ObjectRecord) * numObjects_);
+	file.write((const char*)keys_, sizeof(KeyRecord) * numKeys_);
+	file.write(strings_, stringBytes_);
+	return (bool)file;
+}
+
+//Adds the octahedron standing on its bottom vertex c to the mesh array
+static void createOctahedron(std::deque<TriangleMesh>& meshes, glm::vec3 c, float width, float height)
+{
+	float hh = height / 2;
+	float hw = width / 2;
+
+	std::vector<glm::vec3> vertices = {
+		glm::vec3(c.x, c.y, c.z),				//0: bottom
+		glm::vec3(c.x, c.y+hh, c.z+hw),			//1..4: the four corners of the middle square
+		glm::vec3(c.x-hw, c.y+hh, c.z),
+		glm::vec3(c.x+hw, c.y+hh, c.z),
+		glm::vec3(c.x, c.y+hh, c.z-hw),
+		glm::vec3(c.x, c.y+height, c.z) };		//5: top
+	std::vector<int> indices = {
+		0, 1, 2,  0, 3, 1,  0, 4, 3,  0, 2, 4,
+		5, 2, 1,  5, 1, 3,  5, 3, 4,  5, 4, 2 };
+	meshes.emplace_back(vertices, indices);
+}
+
+/**
+* Creates the scene objects, in the order of the scene file, and appends them to
+* sceneObjects. The objects are owned by the SceneFile and live as long as it does.
+* Prototypes are created too, but only their instances are scene objects.
+* Returns false if a mesh file cannot be loaded.
+*/
+bool SceneFile::createObjects(std::vector<SceneObject*>& sceneObjects)
+{
+	int counts[OBJECT_INSTANCE + 1] = { 0 };
+	for (int i = 0; i < numObjects_; i++) counts[objects_[i].type]++;
+	spheres_.clear();
+	planes_.clear();
+	cylinders_.clear();
+	cones_.clear();
+	meshes_.clear();
+	spheres_.reserve(counts[OBJECT_SPHERE]);		//Reserved up front: the pointers handed out must stay valid
+	planes_.reserve(counts[OBJECT_PLANE]);
+	cylinders_.reserve(counts[OBJECT_CYLINDER]);
+	cones_.reserve(counts[OBJECT_CONE]);
+	instances_.clear();
+	instances_.reserve(counts[OBJECT_INSTANCE]);
+	created_.assign(numObjects_, nullptr);
+
+	for (int i = 0; i < numObjects_; i++)
+	{
+		const ObjectRecord& rec = objects_[i];
+		const float* p = rec.p;
+		SceneObject* obj = nullptr;
+		switch (rec.type)
+		{
+		case OBJECT_SPHERE:
+			spheres_.emplace_back(glm::vec3(p[0], p[1], p[2]), p[3]);
+			obj = &spheres_.back();
+			break;
+		case OBJECT_PLANE:
+			if (rec.count == 3) planes_.emplace_back(glm::vec3(p[0], p[1], p[2]), glm::vec3(p[3], p[4], p[5]), glm::vec3(p[6], p[7], p[8]));
+			else planes_.emplace_back(glm::vec3(p[0], p[1], p[2]), glm::vec3(p[3], p[4], p[5]), glm::vec3(p[6], p[7], p[8]), glm::vec3(p[9], p[10], p[11]));
+			obj = &planes_.back();
+			break;
+		case OBJECT_CYLINDER:
+			cylinders_.emplace_back(glm::vec3(p[0], p[1], p[2]), p[3], p[4]);
+			obj = &cylinders_.back();
+			break;
+		case OBJECT_CONE:
+			cones_.emplace_back(glm::vec3(p[0], p[1], p[2]), p[3], p[4]);
+			obj = &cones_.back();
+			break;
+		case OBJECT_MESH:
+		{
+			meshes_.emplace_back();
+			const char* path = strings_ + rec.path;
+			size_t n = strlen(path);
+			bool loaded = (n >= 4 && strcmp(path + n - 4, ".obj") == 0) ? meshes_.back().loadOBJ(path) : meshes_.back().loadBinary(path);
+			if (!loaded) return false;
+			obj = &meshes_.back();
+			break;
+		}
+		case OBJECT_OCTAHEDRON:
+			createOctahedron(meshes_, glm::vec3(p[0], p[1], p[2]), p[3], p[4]);
+			obj = &meshes_.back();
+			break;
+		case OBJECT_INSTANCE:
+		{
+			glm::mat4 toWorld(1);
+			for (int row = 0; row < 3; row++)
+				for (int col = 0; col < 4; col++) toWorld[col][row] = p[row * 4 + col];
+			instances_.emplace_back(created_[rec.count], toWorld);
+			obj = &instances_.back();
+			break;
+		}
+		default:
+			continue;
+		}
+		created_[i] = obj;
+		if (rec.material < 0) continue;		//A prototype
+		obj->setMaterial(materials_[rec.material]);
+		sceneObjects.push_back(obj);
+	}
+	return true;
+}
+
+//Converts the light records into lights, one per record
+void SceneFile::createLights(std::vector<Light>& lights) const
+{
+	lights.clear();
+	for (int i = 0; i < numLights_; i++)
+	{
+		const LightRecord& rec = lights_[i];
+		Light light;
+		light.type = rec.type;
+		light.position = glm::vec3(rec.position[0], rec.position[1], rec.position[2]);
+		if (rec.type == LIGHT_SPOT || rec.type == LIGHT_DIRECTIONAL)
+			light.direction = glm::normalize(glm::vec3(rec.direction[0], rec.direction[1], rec.direction[2]));
+		light.color = glm::vec3(rec.color[0], rec.color[1], rec.color[2]);
+		light.cosCutoff = cos(rec.cutoff * (3.14159 / 180));
+		light.range = rec.range;
+		light.radius = rec.radius;
+		light.edgeU = glm::vec3(rec.edgeU[0], rec.edgeU[1], rec.edgeU[2]);
+		light.edgeV = glm::vec3(rec.edgeV[0], rec.edgeV[1], rec.edgeV[2]);
+		light.samples = (rec.samples < 1) ? 1 : rec.samples;
+		lights.push_back(light);
+	}
+}
@@ -0,0 +1,187 @@
+/*----------------------------------------------------------
+* COSC363  Ray Tracer
+*
+*  The scene file class
+*  Reads a scene (camera, lights, textures, materials and
+*  objects) from a text description, and creates its scene
+*  objects. A parsed scene can be saved in a binary form
+*  whose records are the in-memory ones: loading it maps the
+*  file and uses the records in place, with no parsing.
+*  See scene.txt for the text format.
+-------------------------------------------------------------*/
+
+#ifndef H_SCENEFILE
+#define H_SCENEFILE
+
+#include <glm/glm.hpp>
+#include <vector>
+#include <deque>
+#include <string>
+#include <cstdint>
+#include "SceneObject.h"
+#include "Material.h"
+#include "Light.h"
+#include "MappedFile.h"
+#include "Sphere.h"
+#include "Plane.h"
+#include "Cylinder.h"
+#include "Cone.h"
+#include "TriangleMesh.h"
+#include "Instance.h"
+
+enum ObjectType
+{
+	OBJECT_SPHERE = 0,		//p: centre xyz, radius
+	OBJECT_PLANE,			//p: 3 or 4 vertices (count)
+	OBJECT_CYLINDER,		//p: base centre xyz, radius, height
+	OBJECT_CONE,			//p: base centre xyz, radius, height
+	OBJECT_MESH,			//path: OBJ or binary mesh file
+	OBJECT_OCTAHEDRON,		//p: bottom vertex xyz, width, height
+	OBJECT_INSTANCE			//count: index of the prototype's record, p: rows of the 3 x 4 affine transform
+};
+
+struct ObjectRecord
+{
+	int32_t type = OBJECT_SPHERE;
+	int32_t material = 0;		//Index into the materials; -1 for a prototype, which is only placed by instances
+	int32_t count = 0;			//Number of plane vertices
+	int32_t path = -1;			//Offset of the file name in the string table
+	float p[12] = { 0 };
+};
+
+struct LightRecord
+{
+	int32_t type = LIGHT_POINT;
+	float position[3] = { 0 };		//All but directional lights
+	float direction[3] = { 0 };		//Spot and directional lights
+	float cutoff = 0;				//Spot lights only: cone half-angle in degrees
+	float range = 0;				//All but directional lights: 0 for unlimited
+	float color[3] = { 1, 1, 1 };
+	float radius = 0;				//Sphere lights
+	float edgeU[3] = { 0 };			//Rectangle lights
+	float edgeV[3] = { 0 };
+	int32_t samples = 16;			//Area lights: most shadow rays per hit
+};
+
+enum KeyTarget
+{
+	KEY_CAMERA = 0,			//translate: eye position
+	KEY_LIGHT,				//translate: light position
+	KEY_INSTANCE			//translate, rotate, scale: motion in the prototype's space
+};
+
+//A keyframe: where a camera, light or instance is at 'frame'; in between, keys are interpolated
+struct KeyRecord
+{
+	int32_t target = KEY_CAMERA;
+	int32_t index = 0;					//Light: index among the lights. Instance: index of its object record
+	float frame = 0;
+	float translate[3] = { 0 };
+	float rotate[4] = { 0, 0, 1, 0 };	//Degrees, axis
+	float scale[3] = { 1, 1, 1 };
+};
+
+struct CameraRecord
+{
+	float eye[3] = { 0, 0, 0 };
+	float distance = 40;			//Distance of the image plane from the eye
+	float width = 20;				//Size of the image plane
+	float height = 20;
+};
+
+struct SettingsRecord
+{
+	float background[3] = { 1, 1, 1 };
+	int32_t fog = 0;				//Whether to fade towards white between the planes below
+	float fogZ[2] = { 0, 0 };		//z1, z2
+	float fogY[2] = { 0, 0 };		//y1, y2
+	int32_t maxDepth = 4;			//Longest chain of rays from the eye (primary ray = 1)
+	float minWeight = 1.0f / 512;	//Rays adding less than this to their pixel are culled
+	int32_t roulette = 1;			//Whether culling is by Russian roulette rather than cut off
+	int32_t aaLevels = 2;			//Adaptive anti-aliasing: times an edge pixel may be subdivided
+	float aaThreshold = 0.1f;		//Colour difference that marks an edge
+	int32_t frames[2] = { 0, 0 };	//First and last frame of the animation
+	int32_t progressive = 0;		//Whether the window starts in progressive mode
+	float progressiveTime = 10;		//Seconds a progressive preview may accumulate samples
+	int32_t progressiveSamples = 64;	//Samples per cell at which it stops anyway
+};
+
+class SceneFile
+{
+private:
+	//Storage for a text scene; unused for a mapped binary scene
+	std::vector<Material> materialData_;
+	std::vector<int32_t> textureData_;		//Offset of each texture's file name in the string table
+	std::vector<LightRecord> lightData_;
+	std::vector<ObjectRecord> objectData_;
+	std::vector<KeyRecord> keyData_;
+	std::vector<char> stringData_;
+	CameraRecord cameraData_;
+	SettingsRecord settingsData_;
+	MappedFile file_;
+
+	//The records in use, pointing into either the vectors above or the mapped file
+	const Material* materials_ = nullptr;
+	const int32_t* textures_ = nullptr;
+	const LightRecord* lights_ = nullptr;
+	const ObjectRecord* objects_ = nullptr;
+	const KeyRecord* keys_ = nullptr;
+	const char* strings_ = nullptr;
+	const CameraRecord* camera_ = &cameraData_;
+	const SettingsRecord* settings_ = &settingsData_;
+	int numMaterials_ = 0;
+	int numTextures_ = 0;
+	int numLights_ = 0;
+	int numObjects_ = 0;
+	int numKeys_ = 0;
+	int stringBytes_ = 0;
+
+	//Objects created by createObjects(): one array per type, not one allocation per object
+	std::vector<Sphere> spheres_;
+	std::vector<Plane> planes_;
+	std::vector<Cylinder> cylinders_;
+	std::vector<Cone> cones_;
+	std::deque<TriangleMesh> meshes_;
+	std::vector<Instance> instances_;
+	std::vector<SceneObject*> created_;		//By object record
+
+	SceneFile(const SceneFile&) = delete;
+	SceneFile& operator=(const SceneFile&) = delete;
+
+	bool loadText(const char* filename);
+	bool loadBinary(const char* filename);
+	void useVectors();
+
+public:
+	SceneFile() {}
+
+	bool load(const char* filename);
+
+	bool saveBinary(const char* filename);
+
+	bool createObjects(std::vector<SceneObject*>& sceneObjects);
+
+	void createLights(std::vector<Light>& lights) const;
+
+	int getNumMaterials() const { return numMaterials_; }
+	const Material& getMaterial(int i) const { return materials_[i]; }
+
+	int getNumTextures() const { return numTextures_; }
+	const char* getTexturePath(int i) const { return strings_ + textures_[i]; }
+
+	int getNumLights() const { return numLights_; }
+	const LightRecord& getLight(int i) const { return lights_[i]; }
+
+	int getNumObjects() const { return numObjects_; }
+	const ObjectRecord& getObject(int i) const { return objects_[i]; }
+	SceneObject* getCreatedObject(int i) const { return created_[i]; }		//After createObjects()
+
+	int getNumKeys() const { return numKeys_; }
+	const KeyRecord& getKey(int i) const { return keys_[i]; }
+
+	const CameraRecord& getCamera() const { return *camera_; }
+
+	const SettingsRecord& getSettings() const { return *settings_; }
+};
+
+#endif //!H_SCENEFILE
@@ -14,51 +14,62 @@ glm::vec3 SceneObject::getColor()
 	return color_;
 }
 
-glm::vec3 SceneObject::lighting(glm::vec3 lightPos, glm::vec3 viewVec, glm::vec3 hit)
-{
-	float ambientTerm = 0.2;
-	float diffuseTerm = 0;
-	float specularTerm = 0;
-	glm::vec3 normalVec = normal(hit);
-	glm::vec3 lightVec = lightPos - hit;
-	lightVec = glm::normalize(lightVec);
-	float lDotn = glm::dot(lightVec, normalVec);
-	if (spec_)
-	{
-		glm::vec3 reflVec = glm::reflect(-lightVec, normalVec);
-		float rDotv = glm::dot(reflVec, viewVec);
-		if (rDotv > 0) specularTerm = pow(rDotv, shin_);
-	}
-	glm::vec3 colorSum = ambientTerm * color_ + lDotn * color_ + specularTerm * glm::vec3(1);
-	return colorSum;
-}
-
-glm::vec3 SceneObject::lighting(glm::vec3 lightPos, glm::vec3 spotlightPos, glm::vec3 spotlightDir, float cutoff, glm::vec3 viewVec, glm::vec3 hit)
-{
-	glm::vec3 lightVec2 = glm::normalize(spotlightPos - hit);
-	float angle = acos(glm::dot(-lightVec2, glm::normalize(spotlightDir)));
-	if (angle > cutoff * (3.14159 / 180)) return lighting(lightPos, viewVec, hit);
-
-	float ambientTerm = 0.2;
-	float diffuseTerm1 = 0;
-	float specularTerm1 = 0;
-	float diffuseTerm2 = 0;
-	float specularTerm2 = 0;
-	glm::vec3 lightVec1 = glm::normalize(lightPos - hit);
-	glm::vec3 normalVec = normal(hit);
-	float lDotn1 = glm::dot(lightVec1, normalVec);
-	float lDotn2 = glm::dot(lightVec2, normalVec);
-	if (spec_)
-	{
-		glm::vec3 reflVec1 = glm::reflect(-lightVec1, normalVec);
-		float rDotv1 = glm::dot(reflVec1, viewVec);
-		if (rDotv1 > 0) specularTerm1 = pow(rDotv1, shin_);
-		glm::vec3 reflVec2 = glm::reflect(-lightVec2, normalVec);
-		float rDotv2 = glm::dot(reflVec2, viewVec);
-		if (rDotv2 > 0) specularTerm2 = pow(rDotv2, shin_);
-	}
-	glm::vec3 colorSum = (ambientTerm * color_) + (lDotn1 * color_ + specularTerm1  * glm::vec3(1)) + (lDotn2 * color_ + specularTerm2 * glm::vec3(1));
-	return colorSum;
+//Phong lighting from a single light, without shadows. surfaceCol is the colour of the surface at the hit point,
+//which is the material colour unless a texture or procedural pattern overrides it.
+glm::vec3 SceneObject::lighting(const Light& light, glm::vec3 viewVec, glm::vec3 hit, glm::vec3 surfaceCol)
+{
+	Material m = getMaterial();
+	glm::vec3 lightVec;
+	float dist, attenuation;
+	glm::vec3 color = m.ambient(surfaceCol);
+	if (light.illuminates(hit, lightVec, dist, attenuation))
+		color += attenuation * m.lighting(normal(hit), lightVec, light.color, viewVec, surfaceCol);
+	return color;
+}
+
+//Packs the surface properties into a Material, which is what the compiled scene stores
+Material SceneObject::getMaterial()
+{
+	Material m;
+	m.color = color_;
+	m.refl = refl_;
+	m.refr = refr_;
+	m.spec = spec_;
+	m.tran = tran_;
+	m.reflc = reflc_;
+	m.refrc = refrc_;
+	m.tranc = tranc_;
+	m.refri = refri_;
+	m.shin = shin_;
+	m.reflfront = reflfront_;
+	m.mapping = mapping_;
+	m.texture = texture_;
+	m.filter = filter_;
+	m.color2 = color2_;
+	m.repeatU = repeat_.x;
+	m.repeatV = repeat_.y;
+	return m;
+}
+
+//Sets all surface properties at once, e.g. from a scene file
+void SceneObject::setMaterial(const Material& m)
+{
+	color_ = m.color;
+	refl_ = m.refl;
+	refr_ = m.refr;
+	spec_ = m.spec;
+	tran_ = m.tran;
+	reflc_ = m.reflc;
+	refrc_ = m.refrc;
+	tranc_ = m.tranc;
+	refri_ = m.refri;
+	shin_ = m.shin;
+	reflfront_ = m.reflfront;
+	mapping_ = m.mapping;
+	texture_ = m.texture;
+	filter_ = m.filter;
+	color2_ = m.color2;
+	repeat_ = glm::vec2(m.repeatU, m.repeatV);
 }
 
 float SceneObject::getReflectionCoeff()
@@ -155,4 +166,50 @@ void SceneObject::setTransparency(bool flag, float tran_coeff)
 {
 	tran_ = flag;
 	tranc_ = tran_coeff;
-}
\ No newline at end of file
+}
+
+//Maps the image texture with the given index over the object, using its UVs
+void SceneObject::setTexture(int texture, int filter)
+{
+	mapping_ = MAP_TEXTURE;
+	texture_ = texture;
+	filter_ = filter;
+}
+
+//Covers the object with a checkerboard of the object colour and col2, repeatU x repeatV squares over its UVs
+void SceneObject::setChecker(glm::vec3 col2, float repeatU, float repeatV)
+{
+	mapping_ = MAP_CHECKER;
+	color2_ = col2;
+	repeat_ = glm::vec2(repeatU, repeatV);
+}
+
+/**
+* Texture coordinates of point p on the object. By default p is projected onto
+* the two longest sides of the bounding box, each scaled to [0, 1]. Subclasses
+* with a natural parametrisation override this.
+*/
+glm::vec2 SceneObject::texcoord(glm::vec3 p)
+{
+	AABB box = bounds();
+	glm::vec3 e = box.max - box.min;
+	int drop = 0;						//The shortest side is the one projected away
+	if (e.y < e[drop]) drop = 1;
+	if (e.z < e[drop]) drop = 2;
+	int u = (drop == 0) ? 1 : 0;
+	int v = (drop == 2) ? 1 : 2;
+	return glm::vec2((p[u] - box.min[u]) / e[u], (p[v] - box.min[v]) / e[v]);
+}
+
+/**
+* For a ray starting inside the object (e.g. just refracted into it): the distance
+* to where it leaves the object, and the unit normal there; -1 if it does not leave.
+* By default the ray is intersected with the object as from outside. Closed solids
+* override this with a direct solution for the far side.
+*/
+float SceneObject::exit(glm::vec3 p0, glm::vec3 dir, glm::vec3& normalVec)
+{
+	float t = intersect(p0, dir);
+	if (t > 0) normalVec = normal(p0 + t * dir);
+	return t;
+}
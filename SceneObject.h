@@ -7,12 +7,16 @@
 *  Being an abstract class, this class cannot be instantiated.
 *  Sphere, Plane etc, must be defined as subclasses of Object
 *      and provide implementations for the virtual functions
-*      intersect()  and normal().
+*      intersect(), normal() and bounds(). They may also
+*      override texcoord() to supply their own UVs.
 -------------------------------------------------------------*/
 
 #ifndef H_SOBJECT
 #define H_SOBJECT
 #include <glm/glm.hpp>
+#include "AABB.h"
+#include "Material.h"
+#include "Light.h"
 
 
 class SceneObject 
@@ -28,14 +32,22 @@ protected:
 	float tranc_ = 0.8;  //coefficient of transparency
 	float refri_ = 1.0;  //refractive index
 	float shin_ = 50.0;  //shininess
+	bool reflfront_ = false;  //reflect only where the normal faces +z
+	int mapping_ = MAP_NONE;  //surface pattern, see MappingMode
+	int texture_ = -1;        //index of the image texture
+	int filter_ = FILTER_TRILINEAR;  //texture filter, see TextureFilter
+	glm::vec3 color2_ = glm::vec3(0);  //colour of the odd checker squares
+	glm::vec2 repeat_ = glm::vec2(1);  //pattern repeats across the UV range
 public:
 	SceneObject() {}
     virtual float intersect(glm::vec3 p0, glm::vec3 dir) = 0;
 	virtual glm::vec3 normal(glm::vec3 pos) = 0;
+	virtual AABB bounds() = 0;
+	virtual glm::vec2 texcoord(glm::vec3 pos);
+	virtual float exit(glm::vec3 p0, glm::vec3 dir, glm::vec3& normalVec);
 	virtual ~SceneObject() {}
 
-	glm::vec3 lighting(glm::vec3 lightPos, glm::vec3 viewVec, glm::vec3 hit);
-	glm::vec3 lighting(glm::vec3 lightPos, glm::vec3 spotlightPos, glm::vec3 spotlightDir, float cutoff, glm::vec3 viewVec, glm::vec3 hit);
+	glm::vec3 lighting(const Light& light, glm::vec3 viewVec, glm::vec3 hit, glm::vec3 surfaceCol);
 	void setColor(glm::vec3 col);
 	void setReflectivity(bool flag);
 	void setReflectivity(bool flag, float refl_coeff);
@@ -45,7 +57,11 @@ public:
 	void setSpecularity(bool flag);
 	void setTransparency(bool flag);
 	void setTransparency(bool flag, float tran_coeff);
+	void setTexture(int texture, int filter = FILTER_TRILINEAR);
+	void setChecker(glm::vec3 col2, float repeatU, float repeatV);
 	glm::vec3 getColor();
+	Material getMaterial();
+	void setMaterial(const Material& m);
 	float getReflectionCoeff();
 	float getRefractionCoeff();
 	float getTransparencyCoeff();
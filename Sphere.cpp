@@ -45,3 +45,40 @@ glm::vec3 Sphere::normal(glm::vec3 p)
     n = glm::normalize(n);
     return n;
 }
+
+/**
+* Returns the axis-aligned box enclosing the sphere.
+*/
+AABB Sphere::bounds()
+{
+    return AABB(center - glm::vec3(radius), center + glm::vec3(radius));
+}
+
+/**
+* Spherical texture coordinates: longitude (u) and latitude (v) of p,
+* both in [0, 1].
+*/
+glm::vec2 Sphere::texcoord(glm::vec3 p)
+{
+	glm::vec3 d = glm::normalize(p - center);
+	float u = 0.5 + atan2(d.x, d.z) / (2 * 3.14159);
+	float v = 0.5 - asin(-d.y) / 3.14159;
+	return glm::vec2(u, v);
+}
+
+/**
+* Exit of a ray starting inside the sphere: the far root of the intersection
+* quadratic. Inside, the discriminant cannot be negative.
+*/
+float Sphere::exit(glm::vec3 p0, glm::vec3 dir, glm::vec3& normalVec)
+{
+    glm::vec3 vdif = p0 - center;
+    float b = glm::dot(dir, vdif);
+    float c = glm::dot(vdif, vdif) - radius*radius;
+    float delta = b*b - c;
+    if (delta < 0) delta = 0;
+    float t = -b + sqrt(delta);
+    if (t < 0.001) return -1.0;
+    normalVec = (p0 + t * dir - center) / radius;
+    return t;
+}
@@ -31,6 +31,15 @@ public:
 
 	glm::vec3 normal(glm::vec3 p);
 
+	AABB bounds();
+
+	glm::vec2 texcoord(glm::vec3 p);
+	float exit(glm::vec3 p0, glm::vec3 dir, glm::vec3& normalVec);
+
+	glm::vec3 getCenter() { return center; }
+
+	float getRadius() { return radius; }
+
 };
 
 #endif //!H_SPHERE
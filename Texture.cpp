@@ -0,0 +1,191 @@
+/*----------------------------------------------------------
+* COSC363  Ray Tracer
+*
+*  The texture class
+*  See Texture.h for the storage layout.
+-------------------------------------------------------------*/
+
+#include "Texture.h"
+#include "TextureBMP.h"
+#include <cmath>
+
+static const int TILE = 4;		//Tile width and height in texels
+
+//Position of texel (x, y) within its 4 x 4 tile: the bits of x and y interleaved
+static inline int morton(int x, int y)
+{
+	return (x & 1) | ((y & 1) << 1) | ((x & 2) << 1) | ((y & 2) << 2);
+}
+
+static inline glm::vec4 unpack(uint32_t t)
+{
+	const float s = 1.0f / 255;
+	return glm::vec4((t & 0xff) * s, ((t >> 8) & 0xff) * s, ((t >> 16) & 0xff) * s, (t >> 24) * s);
+}
+
+//Index in texels_ of texel (x, y) of a level, 0 <= x < width, 0 <= y < height
+inline size_t Texture::address(const Level& level, int x, int y) const
+{
+	size_t tile = (size_t)(y / TILE) * level.tilesX + x / TILE;
+	return level.offset + tile * TILE * TILE + morton(x % TILE, y % TILE);
+}
+
+//Average of four packed RGBA8 texels, rounded, channel by channel
+static inline uint32_t average(uint32_t a, uint32_t b, uint32_t c, uint32_t d)
+{
+	uint32_t result = 0;
+	for (int shift = 0; shift < 32; shift += 8)
+	{
+		uint32_t sum = ((a >> shift) & 0xff) + ((b >> shift) & 0xff) + ((c >> shift) & 0xff) + ((d >> shift) & 0xff);
+		result |= ((sum + 2) >> 2) << shift;
+	}
+	return result;
+}
+
+/**
+* Builds the texture from width x height pixels of 'channels' bytes each (3 or 4),
+* stored row by row, rowBytes apart, starting with the bottom row (t = 0). With
+* bgr set the pixels are in BMP order (B, G, R, A); they are swizzled to RGBA as
+* they are tiled, so the source is read only once and can be a mapped file.
+* Every mip level halves the size of the one before, down to 1 x 1; each of its
+* texels is the average of the 2 x 2 texels it covers.
+*/
+void Texture::create(int width, int height, int channels, const unsigned char* pixels, int rowBytes, bool bgr)
+{
+	texels_.clear();
+	levels_.clear();
+	if (width <= 0 || height <= 0 || channels < 3 || pixels == nullptr) return;
+
+	//Level sizes and offsets; every level is padded to whole tiles
+	size_t total = 0;
+	for (int w = width, h = height; ; w = (w > 1 ? w / 2 : 1), h = (h > 1 ? h / 2 : 1))
+	{
+		Level level;
+		level.width = w;
+		level.height = h;
+		level.tilesX = (w + TILE - 1) / TILE;
+		level.offset = total;
+		total += (size_t)level.tilesX * ((h + TILE - 1) / TILE) * TILE * TILE;
+		levels_.push_back(level);
+		if (w == 1 && h == 1) break;
+	}
+	texels_.assign(total, 0);
+
+	int ri = bgr ? 2 : 0, bi = bgr ? 0 : 2;
+	for (int y = 0; y < height; y++)
+	{
+		const unsigned char* row = pixels + (size_t)y * rowBytes;
+		for (int x = 0; x < width; x++)
+		{
+			const unsigned char* p = row + x * channels;
+			uint32_t a = (channels > 3) ? p[3] : 255;
+			texels_[address(levels_[0], x, y)] = p[ri] | (p[1] << 8) | (p[bi] << 16) | (a << 24);
+		}
+	}
+
+	for (size_t l = 1; l < levels_.size(); l++)
+	{
+		const Level& prev = levels_[l - 1];
+		const Level& level = levels_[l];
+		for (int y = 0; y < level.height; y++)
+		{
+			int y0 = 2 * y, y1 = (2 * y + 1 < prev.height) ? 2 * y + 1 : y0;		//Odd sizes: the last row is repeated
+			for (int x = 0; x < level.width; x++)
+			{
+				int x0 = 2 * x, x1 = (2 * x + 1 < prev.width) ? 2 * x + 1 : x0;
+				texels_[address(level, x, y)] = average(texels_[address(prev, x0, y0)], texels_[address(prev, x1, y0)],
+					texels_[address(prev, x0, y1)], texels_[address(prev, x1, y1)]);
+			}
+		}
+	}
+}
+
+//Texel (x, y) of a level; coordinates outside the image wrap around
+inline uint32_t Texture::fetch(const Level& level, int x, int y) const
+{
+	x %= level.width;
+	y %= level.height;
+	if (x < 0) x += level.width;
+	if (y < 0) y += level.height;
+	return texels_[address(level, x, y)];
+}
+
+//Bilinear interpolation of the four texels around uv on one level
+glm::vec4 Texture::bilinear(int l, glm::vec2 uv) const
+{
+	const Level& level = levels_[l];
+	float fx = uv.x * level.width - 0.5f, fy = uv.y * level.height - 0.5f;
+	float x0 = floor(fx), y0 = floor(fy);
+	float ax = fx - x0, ay = fy - y0;
+	int ix = (int)x0, iy = (int)y0;
+	glm::vec4 c00 = unpack(fetch(level, ix, iy)), c10 = unpack(fetch(level, ix + 1, iy));
+	glm::vec4 c01 = unpack(fetch(level, ix, iy + 1)), c11 = unpack(fetch(level, ix + 1, iy + 1));
+	return (1 - ay) * ((1 - ax) * c00 + ax * c10) + ay * ((1 - ax) * c01 + ax * c11);
+}
+
+/**
+* Returns the colour at texture coordinates uv; the texture repeats outside [0, 1].
+* footprint is the size, in texture coordinates, of the area the lookup stands
+* for (e.g. the footprint of a pixel's ray on the surface), and selects the mip
+* level for the bilinear and trilinear filters.
+*/
+glm::vec3 Texture::sample(glm::vec2 uv, float footprint, int filter) const
+{
+	if (levels_.empty()) return glm::vec3(0);
+	uv -= glm::floor(uv);
+	if (filter == FILTER_NEAREST)
+	{
+		const Level& level = levels_[0];
+		return glm::vec3(unpack(fetch(level, (int)(uv.x * level.width), (int)(uv.y * level.height))));
+	}
+
+	//Level of detail: log2 of the footprint in texels of the full-size image
+	int size = levels_[0].width > levels_[0].height ? levels_[0].width : levels_[0].height;
+	float texels = footprint * size;
+	float lod = (texels > 1) ? log2(texels) : 0;
+	float maxLod = levels_.size() - 1;
+	if (lod > maxLod) lod = maxLod;
+
+	if (filter == FILTER_BILINEAR) return glm::vec3(bilinear((int)(lod + 0.5f), uv));
+	int l0 = (int)lod;
+	float a = lod - l0;
+	glm::vec4 c = bilinear(l0, uv);
+	if (a > 0) c = (1 - a) * c + a * bilinear(l0 + 1, uv);
+	return glm::vec3(c);
+}
+
+/**
+* Returns the texture loaded from a BMP file, loading it on first use. A file
+* that cannot be loaded gives an empty texture, which samples as black.
+* Several threads may load at once: different files load in parallel, and a
+* thread asking for a file that is being loaded waits for it.
+*/
+const Texture* TextureRegistry::load(const std::string& filename)
+{
+	Entry* entry;
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		std::unique_ptr<Entry>& e = textures_[filename];
+		if (!e) e.reset(new Entry());
+		entry = e.get();
+	}
+	std::call_once(entry->loaded, [&]()
+	{
+		TextureBMP image(filename.c_str());
+		entry->texture.create(image.getWidth(), image.getHeight(), image.getChannels(), image.getData(), image.getRowBytes(), true);
+	});
+	return &entry->texture;
+}
+
+//Starts loading a texture on a background thread; get() on the result waits for it
+std::future<const Texture*> TextureRegistry::loadAsync(const std::string& filename)
+{
+	return std::async(std::launch::async, [this, filename]() { return load(filename); });
+}
+
+//Releases all textures; pointers returned by load() are no longer valid
+void TextureRegistry::clear()
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	textures_.clear();
+}
@@ -0,0 +1,86 @@
+/*----------------------------------------------------------
+* COSC363  Ray Tracer
+*
+*  The texture class
+*  Holds an image with its chain of mipmaps, packed as RGBA8
+*  in 4 x 4 texel tiles (64 bytes, one cache line) whose
+*  texels are in Morton order, so that the texels around a
+*  lookup are close together whichever way the surface is
+*  slanted. Supports nearest, bilinear and trilinear
+*  filtering; the mip level comes from the size of the
+*  lookup's footprint in texture space.
+*  Textures are shared through the TextureRegistry: a file
+*  used by several materials is only loaded once, and files
+*  can be loaded on background threads.
+-------------------------------------------------------------*/
+
+#ifndef H_TEXTURE
+#define H_TEXTURE
+
+#include <glm/glm.hpp>
+#include <vector>
+#include <map>
+#include <memory>
+#include <string>
+#include <cstdint>
+#include <mutex>
+#include <future>
+
+enum TextureFilter
+{
+	FILTER_NEAREST = 0,		//Closest texel of the full-size image
+	FILTER_BILINEAR,		//Bilinear, on the closest mip level
+	FILTER_TRILINEAR,		//Bilinear on the two closest mip levels, blended
+	NUM_FILTERS
+};
+
+class Texture
+{
+private:
+	struct Level
+	{
+		int width, height;
+		int tilesX;				//Tiles per row
+		size_t offset;			//Index of the level's first texel in texels_
+	};
+	std::vector<uint32_t> texels_;		//All levels, tiled; R in the low byte
+	std::vector<Level> levels_;
+
+	size_t address(const Level& level, int x, int y) const;
+	uint32_t fetch(const Level& level, int x, int y) const;
+	glm::vec4 bilinear(int level, glm::vec2 uv) const;
+
+public:
+	Texture() {}
+
+	void create(int width, int height, int channels, const unsigned char* pixels, int rowBytes, bool bgr);
+
+	glm::vec3 sample(glm::vec2 uv, float footprint, int filter) const;
+
+	int getWidth() const { return levels_.empty() ? 0 : levels_[0].width; }
+
+	int getHeight() const { return levels_.empty() ? 0 : levels_[0].height; }
+
+	int getNumLevels() const { return levels_.size(); }
+};
+
+class TextureRegistry
+{
+private:
+	struct Entry
+	{
+		std::once_flag loaded;
+		Texture texture;
+	};
+	std::map<std::string, std::unique_ptr<Entry>> textures_;		//By file name
+	std::mutex mutex_;
+
+public:
+	const Texture* load(const std::string& filename);
+
+	std::future<const Texture*> loadAsync(const std::string& filename);
+
+	void clear();
+};
+
+#endif //!H_TEXTURE
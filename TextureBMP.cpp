@@ -8,17 +8,22 @@
 //=====================================================================
 
 #include "TextureBMP.h"
+#include <cstring>
+#include <cstdint>
 
 TextureBMP::TextureBMP(const char* filename)
 {
 	imageWid = 0;
 	imageHgt = 0;
+	imageChnls = 0;
+	rowBytes = 0;
+	imageData = NULL;
     if (loadBMPImage(filename)) {
 		cout << "Image " << filename << "  loaded successfully." << endl;
 		//cout << "Width = " << imageWid << "  Height = " << imageHgt <<
 		//	"  Channels = " << imageChnls << endl;
     } else {
-        cerr << "Could not load image.";
+        cerr << "Could not load image." << endl;
     }
 }
 
@@ -31,59 +36,62 @@ glm::vec3 TextureBMP::getColorAt(float s, float t)
     int i = (int) (s * imageWid);  //pixel coordinates
     int j = (int) (t * imageHgt);
 	if(i < 0 || i > imageWid-1 || j < 0 || j > imageHgt-1) return glm::vec3(0);
-    int index = ((j * imageWid) + i) * imageChnls;
+    const unsigned char* pixel = imageData + j * rowBytes + i * imageChnls;
 
-    int r = imageData[index];
-    int g = imageData[index + 1];
-    int b = imageData[index + 2];
-
-	if(r < 0) r += 255;   //Unsigned byte values
-	if(g < 0) g += 255;
-	if(b < 0) b += 255;
- 
-    float rn = (float)r / 255.0;  //Normalized colour values
-    float gn = (float)g / 255.0;
-    float bn = (float)b / 255.0;
+    float rn = pixel[2] / 255.0f;  //Normalized colour values; the file stores B, G, R
+    float gn = pixel[1] / 255.0f;
+    float bn = pixel[0] / 255.0f;
     return glm::vec3(rn, gn, bn);
 }
 
+//Little-endian header fields
+static int32_t readInt(const char* p)
+{
+    uint32_t v = (unsigned char)p[0] | ((unsigned char)p[1] << 8) | ((unsigned char)p[2] << 16) | ((uint32_t)(unsigned char)p[3] << 24);
+    return (int32_t)v;
+}
+
+static int readShort(const char* p)
+{
+    return (unsigned char)p[0] | ((unsigned char)p[1] << 8);
+}
+
 bool TextureBMP::loadBMPImage(const char* filename)
 {
-    char header1[18], header2[24];
-    short int planes, bpp;
-    int wid, hgt;
-    int nbytes, size, indx, temp;
-    ifstream file( filename, ios::in | ios::binary);
-    if(!file)
+    if(!file.open(filename))
     {
         cout << "*** Error opening image file: " << filename << endl;
         return false;
     }
-    file.read (header1, 18);        //Initial part of header
-    file.read ((char*)&wid, 4);     //Width
-    file.read ((char*)&hgt, 4);     //Height
-    file.read ((char*)&planes, 2);  //Planes
-    file.read ((char*)&bpp, 2);     //Bits per pixel
-    file.read (header2, 24);        //Remaining part of header
+    const char* header = file.data();
+    if(file.size() < 54 || header[0] != 'B' || header[1] != 'M')
+    {
+        cout << "*** Not a BMP file: " << filename << endl;
+        file.close();
+        return false;
+    }
+
+    int offset = readInt(header + 10);      //Start of the pixel data
+    int wid = readInt(header + 18);         //Width
+    int hgt = readInt(header + 22);         //Height; negative for top-down files
+    int bpp = readShort(header + 28);       //Bits per pixel
+    int compression = readInt(header + 30); //0: none, 3: bit fields (the usual BGRA masks for 32 bits)
 
-    nbytes = bpp / 8;           //No. of bytes per pixels
-    size = wid * hgt * nbytes;  //Total number of bytes to be read
-    imageData = new char[size];
-    file.read(imageData, size);
-    if(nbytes > 2)   //swap R and B
+    int nbytes = bpp / 8;           //No. of bytes per pixels
+    int stride = (wid * nbytes + 3) & ~3;
+    if(wid <= 0 || hgt <= 0 || (nbytes != 3 && nbytes != 4) || (compression != 0 && compression != 3)
+        || offset < 54 || (size_t)offset + (size_t)stride * hgt > file.size())
     {
-        for(int i = 0; i < wid*hgt;  i++)
-        {
-            indx = i*nbytes;
-            temp = imageData[indx];
-            imageData[indx] = imageData[indx+2];
-            imageData[indx+2] = temp;
-        }
+        cout << "*** Unsupported image file: " << filename << endl;
+        file.close();
+        return false;
     }
 
     imageWid = wid;
     imageHgt = hgt;
     imageChnls = nbytes;
+    rowBytes = stride;
+    imageData = (const unsigned char*)file.data() + offset;
 
     return true;
 }
@@ -1,7 +1,9 @@
 //=====================================================================
 // Image loader for files in BMP format.
-// Assumption:  Uncompressed data; 24 bits per pixel, Windows BMP.
+// Assumption:  Uncompressed data; 24 or 32 bits per pixel, Windows BMP.
 // Class definition suitable for ray tracing applications
+// The file is memory-mapped and its pixels are used in place, in the
+// file's BGR(A) order: the R/B swap is done by whoever reads them.
 // Author:
 // R. Mukundan, Department of Computer Science and Software Engineering
 // University of Canterbury, Christchurch, New Zealand.
@@ -11,21 +13,29 @@
 #define H_TEXBMP
 
 #include <iostream>
-#include <fstream>
 #include <glm/glm.hpp>
+#include "MappedFile.h"
 using namespace std;
 
 class TextureBMP
 {
     private:
         int imageWid, imageHgt, imageChnls;  //Width, height, number of channels
-        char* imageData;
+        int rowBytes;                        //Distance between rows; rows are padded to 4 bytes
+        const unsigned char* imageData;      //Bottom row first, BGR(A), in the mapped file
+        MappedFile file;
         bool loadBMPImage(const char* string);
+        TextureBMP(const TextureBMP&) = delete;
+        TextureBMP& operator=(const TextureBMP&) = delete;
     public:
-		TextureBMP(): imageWid(0), imageHgt(0), imageChnls(0) {}
+		TextureBMP(): imageWid(0), imageHgt(0), imageChnls(0), rowBytes(0), imageData(NULL) {}
         TextureBMP(const char* string);
         glm::vec3 getColorAt(float s, float t);
+        int getWidth() { return imageWid; }
+        int getHeight() { return imageHgt; }
+        int getChannels() { return imageChnls; }
+        int getRowBytes() { return rowBytes; }
+        const unsigned char* getData() { return imageData; }
 };
 
 #endif
-
@@ -0,0 +1,138 @@
+/*----------------------------------------------------------
+* COSC363  Ray Tracer
+*
+*  The tile renderer class
+*  Splits the image plane into square tiles and hands them
+*  to a pool of worker threads. Every worker owns a queue of
+*  tiles; once its own queue runs dry it steals tiles from
+*  the back of the other workers' queues.
+-------------------------------------------------------------*/
+
+#include "TileRenderer.h"
+
+static int defaultThreads(int numThreads)
+{
+	if (numThreads > 0) return numThreads;
+	int n = (int)std::thread::hardware_concurrency();
+	return (n > 0) ? n : 1;
+}
+
+TileRenderer::TileRenderer(int numThreads) :
+	numThreads_(defaultThreads(numThreads)), queues_(numThreads_)
+{
+	//The thread calling render() acts as worker 0, so the pool only needs numThreads_-1 extra threads
+	for (int id = 1; id < numThreads_; id++)
+		workers_.push_back(std::thread(&TileRenderer::workerLoop, this, id));
+}
+
+TileRenderer::~TileRenderer()
+{
+	{
+		std::lock_guard<std::mutex> guard(mutex_);
+		stop_ = true;
+	}
+	start_.notify_all();
+	for (size_t i = 0; i < workers_.size(); i++) workers_[i].join();
+}
+
+int TileRenderer::getNumThreads()
+{
+	return numThreads_;
+}
+
+/**
+* Renders one frame. The image of width x height cells is split into
+* tileSize x tileSize tiles, and func is called exactly once per tile
+* from one of the workers. Returns once every tile has been rendered.
+*/
+void TileRenderer::render(int width, int height, int tileSize, TileFunc func)
+{
+	int tilesX = (width + tileSize - 1) / tileSize;
+	int tilesY = (height + tileSize - 1) / tileSize;
+	int numTiles = tilesX * tilesY;
+
+	//Deal out contiguous runs of tiles so that each worker starts on a coherent region
+	for (int k = 0; k < numTiles; k++)
+	{
+		Tile tile;
+		tile.x0 = (k % tilesX) * tileSize;
+		tile.y0 = (k / tilesX) * tileSize;
+		tile.x1 = (tile.x0 + tileSize < width) ? tile.x0 + tileSize : width;
+		tile.y1 = (tile.y0 + tileSize < height) ? tile.y0 + tileSize : height;
+		WorkQueue& queue = queues_[(long)k * numThreads_ / numTiles];
+		std::lock_guard<std::mutex> guard(queue.lock);
+		queue.tiles.push_back(tile);
+	}
+
+	{
+		std::lock_guard<std::mutex> guard(mutex_);
+		job_ = func;
+		pending_ = numTiles;
+		active_ = numThreads_ - 1;
+		generation_++;
+	}
+	start_.notify_all();
+
+	runTiles(0);
+
+	std::unique_lock<std::mutex> lock(mutex_);
+	done_.wait(lock, [this] { return pending_ == 0 && active_ == 0; });
+	job_ = nullptr;
+}
+
+void TileRenderer::workerLoop(int id)
+{
+	unsigned long seen = 0;
+	while (true)
+	{
+		{
+			std::unique_lock<std::mutex> lock(mutex_);
+			start_.wait(lock, [&] { return stop_ || generation_ != seen; });
+			if (stop_) return;
+			seen = generation_;
+		}
+		runTiles(id);
+
+		std::lock_guard<std::mutex> guard(mutex_);
+		active_--;
+		if (active_ == 0 && pending_ == 0) done_.notify_all();
+	}
+}
+
+//Renders tiles from the worker's own queue, then from other queues, until none are left
+void TileRenderer::runTiles(int id)
+{
+	Tile tile;
+	while (popTile(id, tile) || stealTile(id, tile))
+	{
+		job_(tile);
+
+		std::lock_guard<std::mutex> guard(mutex_);
+		pending_--;
+		if (active_ == 0 && pending_ == 0) done_.notify_all();
+	}
+}
+
+bool TileRenderer::popTile(int id, Tile& tile)
+{
+	WorkQueue& queue = queues_[id];
+	std::lock_guard<std::mutex> guard(queue.lock);
+	if (queue.tiles.empty()) return false;
+	tile = queue.tiles.front();
+	queue.tiles.pop_front();
+	return true;
+}
+
+bool TileRenderer::stealTile(int id, Tile& tile)
+{
+	for (int k = 1; k < numThreads_; k++)
+	{
+		WorkQueue& victim = queues_[(id + k) % numThreads_];
+		std::lock_guard<std::mutex> guard(victim.lock);
+		if (victim.tiles.empty()) continue;
+		tile = victim.tiles.back();
+		victim.tiles.pop_back();
+		return true;
+	}
+	return false;
+}
@@ -0,0 +1,67 @@
+/*----------------------------------------------------------
+* COSC363  Ray Tracer
+*
+*  The tile renderer class
+*  Splits the image plane into square tiles and hands them
+*  to a pool of worker threads. Every worker owns a queue of
+*  tiles; once its own queue runs dry it steals tiles from
+*  the back of the other workers' queues.
+-------------------------------------------------------------*/
+
+#ifndef H_TILERENDERER
+#define H_TILERENDERER
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+struct Tile
+{
+	int x0 = 0, y0 = 0;		//First cell of the tile (inclusive)
+	int x1 = 0, y1 = 0;		//Last cell of the tile (exclusive)
+};
+
+class TileRenderer
+{
+public:
+	typedef std::function<void(const Tile&)> TileFunc;
+
+	TileRenderer(int numThreads = 0);	//0 = one worker per hardware thread
+	~TileRenderer();
+
+	void render(int width, int height, int tileSize, TileFunc func);
+
+	int getNumThreads();
+
+private:
+	struct WorkQueue
+	{
+		std::mutex lock;
+		std::deque<Tile> tiles;
+	};
+
+	int numThreads_;
+	std::vector<WorkQueue> queues_;		//One queue per worker; queue 0 belongs to the calling thread
+	std::mutex mutex_;
+	std::condition_variable start_;
+	std::condition_variable done_;
+	TileFunc job_;
+	unsigned long generation_ = 0;		//Incremented each time a new frame is submitted
+	int pending_ = 0;					//Tiles not yet finished in the current frame
+	int active_ = 0;					//Pool workers still inside the current frame
+	bool stop_ = false;
+	std::vector<std::thread> workers_;
+
+	TileRenderer(const TileRenderer&) = delete;
+	TileRenderer& operator=(const TileRenderer&) = delete;
+
+	void workerLoop(int id);
+	void runTiles(int id);
+	bool popTile(int id, Tile& tile);
+	bool stealTile(int id, Tile& tile);
+};
+
+#endif //!H_TILERENDERER
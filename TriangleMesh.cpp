@@ -0,0 +1,474 @@
+/*----------------------------------------------------------
+* COSC363  Ray Tracer
+*
+*  The triangle mesh class
+*  This is a subclass of Object, and hence implements the
+*  methods intersect() and normal().
+-------------------------------------------------------------*/
+
+#include "TriangleMesh.h"
+#include <iostream>
+#include <fstream>
+#include <unordered_map>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <math.h>
+
+const float INSIDE_EPS = 1.e-3;	//Barycentric tolerance when locating the triangle under a point
+
+/**
+* Header of the binary mesh format. All fields are little-endian and every
+* section is a plain array of 4-byte values, so the file is used in place:
+*   header
+*   positions   float[3 * numVerts]
+*   normals     float[3 * numVerts]       (only if hasNormals != 0)
+*   indices     uint32[3 * numTris]       (in BVH leaf order)
+*   nodes       BVHNode[numNodes]         (min xyz, max xyz, start, count)
+*/
+struct MeshFileHeader
+{
+	char magic[8];
+	uint32_t numVerts;
+	uint32_t numTris;
+	uint32_t numNodes;
+	uint32_t hasNormals;
+	uint32_t reserved[2];
+};
+
+static const char MESH_MAGIC[8] = { 'R', 'T', 'M', 'E', 'S', 'H', '0', '1' };
+
+static_assert(sizeof(MeshFileHeader) == 32, "unexpected mesh header layout");
+static_assert(sizeof(BVHNode) == 32, "unexpected BVH node layout");
+
+//Builds a mesh from a vertex list and 3 indices per triangle
+TriangleMesh::TriangleMesh(const std::vector<glm::vec3>& vertices, const std::vector<int>& indices)
+{
+	for (size_t i = 0; i < vertices.size(); i++)
+	{
+		positionData_.push_back(vertices[i].x);
+		positionData_.push_back(vertices[i].y);
+		positionData_.push_back(vertices[i].z);
+	}
+	indexData_.assign(indices.begin(), indices.end());
+	build();
+}
+
+//Builds the BVH over the triangles held in the vectors, reorders them into leaf order and points the buffers at them
+void TriangleMesh::build()
+{
+	numVerts_ = positionData_.size() / 3;
+	numTris_ = indexData_.size() / 3;
+	positions_ = positionData_.empty() ? nullptr : &positionData_[0];
+	normals_ = normalData_.empty() ? nullptr : &normalData_[0];
+
+	std::vector<AABB> boxes(numTris_);
+	for (int tri = 0; tri < numTris_; tri++)
+	{
+		for (int k = 0; k < 3; k++) boxes[tri].expand(vertex(indexData_[3*tri + k]));
+	}
+	BVH bvh;
+	bvh.build(boxes);
+
+	const std::vector<int>& order = bvh.getIndices();
+	std::vector<uint32_t> sorted(indexData_.size());
+	for (int i = 0; i < numTris_; i++)
+	{
+		for (int k = 0; k < 3; k++) sorted[3*i + k] = indexData_[3*order[i] + k];
+	}
+	indexData_.swap(sorted);
+	nodeData_ = bvh.getNodes();
+
+	indices_ = indexData_.empty() ? nullptr : &indexData_[0];
+	nodes_ = nodeData_.empty() ? nullptr : &nodeData_[0];
+	numNodes_ = nodeData_.size();
+}
+
+void TriangleMesh::clear()
+{
+	positionData_.clear();
+	normalData_.clear();
+	indexData_.clear();
+	nodeData_.clear();
+	file_.close();
+	positions_ = normals_ = nullptr;
+	indices_ = nullptr;
+	nodes_ = nullptr;
+	numVerts_ = numTris_ = numNodes_ = 0;
+}
+
+glm::vec3 TriangleMesh::vertex(uint32_t i) const
+{
+	return glm::vec3(positions_[3*i], positions_[3*i + 1], positions_[3*i + 2]);
+}
+
+//Reads one "v/vt/vn" corner of an OBJ face; indices are returned 0-based, -1 if absent
+static bool parseCorner(char*& s, int numPositions, int numNormals, int& pos, int& nrm)
+{
+	char* end;
+	long v = strtol(s, &end, 10);
+	if (end == s) return false;
+	pos = (v < 0) ? numPositions + v : v - 1;
+	nrm = -1;
+	s = end;
+	if (*s == '/')
+	{
+		s++;
+		strtol(s, &end, 10);		//Texture coordinates are not used
+		s = end;
+		if (*s == '/')
+		{
+			s++;
+			long n = strtol(s, &end, 10);
+			if (end != s) nrm = (n < 0) ? numNormals + n : n - 1;
+			s = end;
+		}
+	}
+	while (*s != '\0' && *s != ' ' && *s != '\t' && *s != '\r' && *s != '\n') s++;
+	return pos >= 0 && pos < numPositions;
+}
+
+/**
+* Loads a Wavefront OBJ file: v, vn and f records (faces with more than three
+* corners are split into a fan). Vertex normals are used only if every corner
+* of every face has one; the mesh is flat shaded otherwise.
+*/
+bool TriangleMesh::loadOBJ(const char* filename)
+{
+	clear();
+	FILE* file = fopen(filename, "r");
+	if (file == NULL)
+	{
+		std::cout << "*** Error opening mesh file: " << filename << std::endl;
+		return false;
+	}
+
+	std::vector<glm::vec3> positions, normals;
+	std::vector<int> cornerPos, cornerNrm;		//Per triangle corner
+	bool allNormals = true;
+	char line[1024];
+	while (fgets(line, sizeof(line), file))
+	{
+		char* s = line;
+		while (*s == ' ' || *s == '\t') s++;
+		if (s[0] == 'v' && (s[1] == ' ' || s[1] == '\t'))
+		{
+			glm::vec3 p;
+			if (sscanf(s + 2, "%f %f %f", &p.x, &p.y, &p.z) == 3) positions.push_back(p);
+		}
+		else if (s[0] == 'v' && s[1] == 'n')
+		{
+			glm::vec3 n;
+			if (sscanf(s + 3, "%f %f %f", &n.x, &n.y, &n.z) == 3) normals.push_back(n);
+		}
+		else if (s[0] == 'f' && (s[1] == ' ' || s[1] == '\t'))
+		{
+			int pos[64], nrm[64], count = 0;
+			s++;
+			while (count < 64)
+			{
+				while (*s == ' ' || *s == '\t') s++;
+				if (!parseCorner(s, positions.size(), normals.size(), pos[count], nrm[count])) break;
+				if (nrm[count] < 0 || nrm[count] >= (int)normals.size()) allNormals = false;
+				count++;
+			}
+			for (int k = 1; k + 1 < count; k++)
+			{
+				int fan[3] = { 0, k, k + 1 };
+				for (int c = 0; c < 3; c++)
+				{
+					cornerPos.push_back(pos[fan[c]]);
+					cornerNrm.push_back(nrm[fan[c]]);
+				}
+			}
+		}
+	}
+	fclose(file);
+	if (cornerPos.empty())
+	{
+		std::cout << "*** No triangles in mesh file: " << filename << std::endl;
+		return false;
+	}
+
+	if (!allNormals || normals.empty())
+	{
+		for (size_t i = 0; i < positions.size(); i++)
+		{
+			positionData_.push_back(positions[i].x);
+			positionData_.push_back(positions[i].y);
+			positionData_.push_back(positions[i].z);
+		}
+		indexData_.assign(cornerPos.begin(), cornerPos.end());
+	}
+	else
+	{
+		//A vertex is a unique (position, normal) pair, so that both share one index
+		std::unordered_map<long long, uint32_t> vertexOf;
+		for (size_t i = 0; i < cornerPos.size(); i++)
+		{
+			long long key = (long long)cornerPos[i] * normals.size() + cornerNrm[i];
+			auto found = vertexOf.find(key);
+			if (found == vertexOf.end())
+			{
+				uint32_t index = positionData_.size() / 3;
+				glm::vec3 p = positions[cornerPos[i]];
+				glm::vec3 n = glm::normalize(normals[cornerNrm[i]]);
+				positionData_.push_back(p.x); positionData_.push_back(p.y); positionData_.push_back(p.z);
+				normalData_.push_back(n.x); normalData_.push_back(n.y); normalData_.push_back(n.z);
+				found = vertexOf.insert(std::make_pair(key, index)).first;
+			}
+			indexData_.push_back(found->second);
+		}
+	}
+
+	build();
+	std::cout << "Mesh " << filename << "  loaded successfully (" << numTris_ << " triangles)." << std::endl;
+	return true;
+}
+
+/**
+* Maps a mesh written by saveBinary(). Nothing is parsed or copied: the buffers
+* point straight into the mapped file, and the OS pages them in as rays reach them.
+* Only the header and the section sizes are checked, not the contents.
+*/
+bool TriangleMesh::loadBinary(const char* filename)
+{
+	clear();
+	if (!file_.open(filename))
+	{
+		std::cout << "*** Error opening mesh file: " << filename << std::endl;
+		return false;
+	}
+
+	MeshFileHeader header;
+	memset(&header, 0, sizeof(header));
+	if (file_.size() >= sizeof(header)) memcpy(&header, file_.data(), sizeof(header));
+	size_t numFloats = 3 * (size_t)header.numVerts;
+	size_t expected = sizeof(header) + 4 * numFloats * (header.hasNormals ? 2 : 1)
+		+ 4 * 3 * (size_t)header.numTris + sizeof(BVHNode) * (size_t)header.numNodes;
+	if (file_.size() < sizeof(header) || memcmp(header.magic, MESH_MAGIC, sizeof(MESH_MAGIC)) != 0
+		|| file_.size() < expected || (header.numTris > 0 && header.numNodes == 0)
+		|| header.numVerts > INT32_MAX || header.numTris > INT32_MAX || header.numNodes > INT32_MAX)
+	{
+		std::cout << "*** Not a valid binary mesh file: " << filename << std::endl;
+		file_.close();
+		return false;
+	}
+
+	const char* data = file_.data() + sizeof(header);
+	positions_ = (const float*)data;
+	data += 4 * numFloats;
+	if (header.hasNormals)
+	{
+		normals_ = (const float*)data;
+		data += 4 * numFloats;
+	}
+	indices_ = (const uint32_t*)data;
+	data += 4 * 3 * (size_t)header.numTris;
+	nodes_ = (const BVHNode*)data;
+	numVerts_ = header.numVerts;
+	numTris_ = header.numTris;
+	numNodes_ = header.numNodes;
+
+	//The indices and the BVH are used as they are, so they must stay inside the mesh:
+	//vertex indices below numVerts, leaves within the triangles, and an inner node's
+	//children after it (which also rules out cycles), no deeper than the traversal stack allows
+	bool valid = true;
+	for (size_t i = 0; i < 3 * (size_t)numTris_ && valid; i++) valid = (indices_[i] < header.numVerts);
+	std::vector<int> depth(valid ? numNodes_ : 0, 0);
+	for (int i = 0; i < numNodes_ && valid; i++)
+	{
+		const BVHNode& node = nodes_[i];
+		if (node.count > 0) valid = node.start >= 0 && (long long)node.start + node.count <= numTris_;
+		else valid = node.count == 0 && i + 1 < numNodes_ && node.start > i && node.start < numNodes_ && depth[i] + 1 < BVH_STACK_SIZE;
+		if (valid && node.count == 0)
+		{
+			depth[i + 1] = std::max(depth[i + 1], depth[i] + 1);
+			depth[node.start] = std::max(depth[node.start], depth[i] + 1);
+		}
+	}
+	if (!valid)
+	{
+		std::cout << "*** Not a valid binary mesh file: " << filename << std::endl;
+		clear();
+		return false;
+	}
+	return true;
+}
+
+//Writes the mesh, including its BVH, in the binary format read by loadBinary()
+bool TriangleMesh::saveBinary(const char* filename)
+{
+	std::ofstream file(filename, std::ios::out | std::ios::binary);
+	if (!file)
+	{
+		std::cout << "*** Error creating mesh file: " << filename << std::endl;
+		return false;
+	}
+
+	MeshFileHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, MESH_MAGIC, sizeof(MESH_MAGIC));
+	header.numVerts = numVerts_;
+	header.numTris = numTris_;
+	header.numNodes = numNodes_;
+	header.hasNormals = (normals_ != nullptr);
+	file.write((const char*)&header, sizeof(header));
+	file.write((const char*)positions_, 4 * 3 * (size_t)numVerts_);
+	if (normals_ != nullptr) file.write((const char*)normals_, 4 * 3 * (size_t)numVerts_);
+	file.write((const char*)indices_, 4 * 3 * (size_t)numTris_);
+	file.write((const char*)nodes_, sizeof(BVHNode) * (size_t)numNodes_);
+	return (bool)file;
+}
+
+/**
+* Double-sided Moller-Trumbore test against one triangle. Returns the distance
+* along the ray, or -1 if the ray misses it or starts on it.
+*/
+float TriangleMesh::intersectTriangle(int tri, glm::vec3 p0, glm::vec3 dir) const
+{
+	glm::vec3 a = vertex(indices_[3*tri]);
+	glm::vec3 e1 = vertex(indices_[3*tri + 1]) - a;
+	glm::vec3 e2 = vertex(indices_[3*tri + 2]) - a;
+	glm::vec3 pv = glm::cross(dir, e2);
+	float det = glm::dot(e1, pv);
+	if (fabs(det) < 1.e-12) return -1;		//Ray parallel to the triangle
+
+	float invDet = 1 / det;
+	glm::vec3 tv = p0 - a;
+	float u = glm::dot(tv, pv) * invDet;
+	if (u < 0 || u > 1) return -1;
+	glm::vec3 qv = glm::cross(tv, e1);
+	float v = glm::dot(dir, qv) * invDet;
+	if (v < 0 || u + v > 1) return -1;
+
+	float t = glm::dot(e2, qv) * invDet;
+	if (t < 0.0001) return -1;
+	return t;
+}
+
+/**
+* Mesh intersection method. The input is a ray (p0, dir).
+* Walks the mesh's own BVH and returns the distance to the closest triangle, or -1.
+*/
+float TriangleMesh::intersect(glm::vec3 p0, glm::vec3 dir)
+{
+	if (numNodes_ == 0) return -1;
+	glm::vec3 invDir = glm::vec3(1) / dir;
+	float tmin = 1.e+30f;
+
+	int stack[BVH_STACK_SIZE];
+	int top = 0;
+	stack[top++] = 0;
+	while (top > 0)
+	{
+		int nodeIndex = stack[--top];
+		const BVHNode& node = nodes_[nodeIndex];
+		if (node.bounds.intersect(p0, invDir, tmin) < 0) continue;
+
+		if (node.count > 0)
+		{
+			for (int tri = node.start; tri < node.start + node.count; tri++)
+			{
+				float t = intersectTriangle(tri, p0, dir);
+				if (t > 0 && t < tmin) tmin = t;
+			}
+		}
+		else
+		{
+			int left = nodeIndex + 1;
+			int right = node.start;
+			float tl = nodes_[left].bounds.intersect(p0, invDir, tmin);
+			float tr = nodes_[right].bounds.intersect(p0, invDir, tmin);
+			if (tl >= 0 && tr >= 0)
+			{
+				if (tr < tl) std::swap(left, right);
+				stack[top++] = right;
+				stack[top++] = left;
+			}
+			else if (tl >= 0) stack[top++] = left;
+			else if (tr >= 0) stack[top++] = right;
+		}
+	}
+	return (tmin < 1.e+30f) ? tmin : -1;
+}
+
+/**
+* Returns the unit normal vector at a given point on the mesh.
+* The point is first matched to the triangle it lies on (the one whose plane is
+* nearest among those containing it), then the vertex normals are interpolated
+* there; without vertex normals the face normal is used, oriented like Plane's.
+*/
+glm::vec3 TriangleMesh::normal(glm::vec3 p)
+{
+	int best = -1;
+	bool bestInside = false;
+	float bestDist = 1.e+30f;
+	float bestU = 0, bestV = 0;
+
+	int stack[BVH_STACK_SIZE];
+	int top = 0;
+	if (numNodes_ > 0) stack[top++] = 0;
+	while (top > 0)
+	{
+		const BVHNode& node = nodes_[stack[--top]];
+		if (!node.bounds.contains(p)) continue;
+
+		if (node.count > 0)
+		{
+			for (int tri = node.start; tri < node.start + node.count; tri++)
+			{
+				glm::vec3 a = vertex(indices_[3*tri]);
+				glm::vec3 b = vertex(indices_[3*tri + 1]);
+				glm::vec3 c = vertex(indices_[3*tri + 2]);
+				glm::vec3 n = glm::cross(c - b, a - b);
+				float area2 = glm::dot(n, n);
+				if (area2 == 0) continue;
+				float dist = fabs(glm::dot(p - a, n)) / sqrt(area2);
+
+				//Barycentric coordinates of p projected onto the triangle
+				glm::vec3 e1 = b - a, e2 = c - a, w = p - a;
+				float d11 = glm::dot(e1, e1), d12 = glm::dot(e1, e2), d22 = glm::dot(e2, e2);
+				float w1 = glm::dot(w, e1), w2 = glm::dot(w, e2);
+				float denom = d11 * d22 - d12 * d12;
+				float u = (d22 * w1 - d12 * w2) / denom;
+				float v = (d11 * w2 - d12 * w1) / denom;
+				bool inside = u >= -INSIDE_EPS && v >= -INSIDE_EPS && u + v <= 1 + INSIDE_EPS;
+
+				if ((inside && !bestInside) || (inside == bestInside && dist < bestDist))
+				{
+					best = tri;
+					bestInside = inside;
+					bestDist = dist;
+					bestU = u;
+					bestV = v;
+				}
+			}
+		}
+		else
+		{
+			stack[top++] = node.start;
+			stack[top++] = &node - nodes_ + 1;
+		}
+	}
+	if (best == -1) return glm::vec3(0, 1, 0);
+
+	uint32_t ia = indices_[3*best], ib = indices_[3*best + 1], ic = indices_[3*best + 2];
+	if (normals_ != nullptr)
+	{
+		glm::vec3 na(normals_[3*ia], normals_[3*ia + 1], normals_[3*ia + 2]);
+		glm::vec3 nb(normals_[3*ib], normals_[3*ib + 1], normals_[3*ib + 2]);
+		glm::vec3 nc(normals_[3*ic], normals_[3*ic + 1], normals_[3*ic + 2]);
+		return glm::normalize(na * (1 - bestU - bestV) + nb * bestU + nc * bestV);
+	}
+	glm::vec3 a = vertex(ia), b = vertex(ib), c = vertex(ic);
+	return glm::normalize(glm::cross(c - b, a - b));
+}
+
+//Returns the axis-aligned box enclosing all triangles
+AABB TriangleMesh::bounds()
+{
+	if (numNodes_ == 0) return AABB();
+	return nodes_[0].bounds;
+}
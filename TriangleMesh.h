@@ -0,0 +1,74 @@
+/*----------------------------------------------------------
+* COSC363  Ray Tracer
+*
+*  The triangle mesh class
+*  This is a subclass of Object, and hence implements the
+*  methods intersect() and normal().
+*  The triangles share indexed vertex (and optional normal)
+*  buffers and have a BVH of their own, so the whole mesh is
+*  a single object in the scene. Meshes are loaded from
+*  Wavefront OBJ files, or from a binary format (see
+*  saveBinary()) that is memory-mapped and used in place.
+-------------------------------------------------------------*/
+
+#ifndef H_TRIANGLEMESH
+#define H_TRIANGLEMESH
+
+#include <glm/glm.hpp>
+#include <vector>
+#include <cstdint>
+#include "SceneObject.h"
+#include "BVH.h"
+#include "MappedFile.h"
+
+class TriangleMesh : public SceneObject
+{
+private:
+	//Storage for meshes that are built or loaded from OBJ; unused for mapped meshes
+	std::vector<float> positionData_;
+	std::vector<float> normalData_;
+	std::vector<uint32_t> indexData_;
+	std::vector<BVHNode> nodeData_;
+	MappedFile file_;
+
+	//The buffers in use, pointing into either the vectors above or the mapped file.
+	//The triangles are stored in BVH leaf order: a leaf covers triangles [start, start+count).
+	const float* positions_ = nullptr;		//3 floats per vertex
+	const float* normals_ = nullptr;		//3 floats per vertex, or nullptr for flat shading
+	const uint32_t* indices_ = nullptr;		//3 vertex indices per triangle
+	const BVHNode* nodes_ = nullptr;
+	int numVerts_ = 0;
+	int numTris_ = 0;
+	int numNodes_ = 0;
+
+	TriangleMesh(const TriangleMesh&) = delete;
+	TriangleMesh& operator=(const TriangleMesh&) = delete;
+
+	void build();
+	void clear();
+	glm::vec3 vertex(uint32_t i) const;
+	float intersectTriangle(int tri, glm::vec3 p0, glm::vec3 dir) const;
+
+public:
+	TriangleMesh() {}
+
+	TriangleMesh(const std::vector<glm::vec3>& vertices, const std::vector<int>& indices);
+
+	bool loadOBJ(const char* filename);
+
+	bool loadBinary(const char* filename);
+
+	bool saveBinary(const char* filename);
+
+	float intersect(glm::vec3 p0, glm::vec3 dir);
+
+	glm::vec3 normal(glm::vec3 p);
+
+	AABB bounds();
+
+	int getNumVerts() { return numVerts_; }
+
+	int getNumTriangles() { return numTris_; }
+};
+
+#endif //!H_TRIANGLEMESH
@@ -0,0 +1,381 @@
+/*----------------------------------------------------------
+* COSC363  Ray Tracer
+*
+*  The wavefront tracer class
+*  See Wavefront.h. The shading is the same as the recursive
+*  formulation: a hit's colour is its local lighting plus the
+*  weighted colours of its reflected, transparent and
+*  refracted rays, with fog applied on top. Fog is affine in
+*  that sum, so it becomes a scale on the hit's weight plus a
+*  constant added to the pixel.
+-------------------------------------------------------------*/
+
+#include "Wavefront.h"
+#include "Ray.h"
+#include <cmath>
+#include <cstring>
+#include <cstdint>
+
+//---Surface colour of a material at a hit point, one function per MappingMode ------
+static glm::vec3 flatColor(const Material& mat, const Ray&, glm::vec3, const ShadingParams&)
+{
+	return mat.color;
+}
+
+//Size of the ray cone's footprint at the hit point in texture coordinates (ray differentials):
+//the hit points of two neighbouring rays, one cone width away, are mapped to UVs as well.
+static float texcoordFootprint(const Ray& ray, glm::vec3 normalVec, glm::vec2 uv, glm::vec2 scale, const CompiledScene& scene)
+{
+	float width = ray.width + ray.spread * ray.dist;
+	if (width <= 0) return 0;
+	glm::vec3 a = glm::normalize(glm::cross(ray.dir, fabs(ray.dir.y) < 0.9 ? glm::vec3(0, 1, 0) : glm::vec3(1, 0, 0)));
+	glm::vec3 b = glm::cross(ray.dir, a);
+	float dn = glm::dot(ray.dir, normalVec);
+	if (fabs(dn) < 1.e-3) dn = (dn < 0) ? -1.e-3 : 1.e-3;		//Grazing hits: the footprint is long but finite
+	float footprint = 0;
+	glm::vec3 offsets[2] = { a, b };
+	for (int k = 0; k < 2; k++)
+	{
+		glm::vec3 dp = width * (offsets[k] - (glm::dot(offsets[k], normalVec) / dn) * ray.dir);	//Neighbour's hit on the tangent plane
+		glm::vec2 duv = scene.texcoord(ray.index, ray.hit + dp) - uv;
+		duv -= glm::floor(duv + glm::vec2(0.5f));		//Across a seam (u = 0 = 1) take the short way round
+		footprint = glm::max(footprint, glm::length(duv * scale));
+	}
+	return footprint;
+}
+
+static glm::vec3 textureColor(const Material& mat, const Ray& ray, glm::vec3 normalVec, const ShadingParams& params)
+{
+	glm::vec2 uv = params.scene->texcoord(ray.index, ray.hit);
+	glm::vec2 scale(mat.repeatU, mat.repeatV);
+	float footprint = (mat.filter == FILTER_NEAREST) ? 0 : texcoordFootprint(ray, normalVec, uv, scale, *params.scene);
+	return (*params.textures)[mat.texture]->sample(uv * scale, footprint, mat.filter);
+}
+
+static glm::vec3 checkerColor(const Material& mat, const Ray& ray, glm::vec3, const ShadingParams& params)
+{
+	glm::vec2 uv = params.scene->texcoord(ray.index, ray.hit);
+	int iu = (int)floor(uv.x * mat.repeatU);
+	int iv = (int)floor(uv.y * mat.repeatV);
+	return ((iu + iv) & 1) ? mat.color2 : mat.color;
+}
+
+static glm::vec3 (*const surfaceColor[NUM_MAPPINGS])(const Material&, const Ray&, glm::vec3, const ShadingParams&) = { flatColor, textureColor, checkerColor };
+
+//A ray continuing from the hit point of 'parent', which has travelled dist
+static PathRay spawn(const PathRay& parent, float dist, glm::vec3 origin, glm::vec3 dir, float weight)
+{
+	PathRay ray;
+	ray.p0 = origin;
+	ray.dir = glm::normalize(dir);
+	ray.width = parent.width + parent.spread * dist;
+	ray.spread = parent.spread;
+	ray.weight = weight;
+	ray.pixel = parent.pixel;
+	ray.step = parent.step + 1;
+	return ray;
+}
+
+static inline uint32_t hash(uint32_t x)
+{
+	x ^= x >> 16;
+	x *= 0x7feb352du;
+	x ^= x >> 15;
+	x *= 0x846ca68bu;
+	x ^= x >> 16;
+	return x;
+}
+
+//Fraction of a light that gets past the objects a shadow ray meets
+static inline float transmission(Occlusion shadow)
+{
+	return (shadow == UNOCCLUDED) ? 1 : (shadow == OCCLUDED_TRANSPARENT) ? 0.6f : 0;
+}
+
+//Point i of the 2D Sobol sequence, as 32-bit fixed point: the bit-reversed index, and
+//the second dimension, whose generator matrix is Pascal's triangle mod 2
+static inline void sobol(uint32_t i, uint32_t& x, uint32_t& y)
+{
+	x = i;
+	x = (x << 16) | (x >> 16);
+	x = ((x & 0x00ff00ffu) << 8) | ((x & 0xff00ff00u) >> 8);
+	x = ((x & 0x0f0f0f0fu) << 4) | ((x & 0xf0f0f0f0u) >> 4);
+	x = ((x & 0x33333333u) << 2) | ((x & 0xccccccccu) >> 2);
+	x = ((x & 0x55555555u) << 1) | ((x & 0xaaaaaaaau) >> 1);
+	y = 0;
+	for (uint32_t v = 1u << 31; i != 0; i >>= 1, v ^= v >> 1)
+		if (i & 1) y ^= v;
+}
+
+/**
+* Visibility of an area light from a hit point, between 0 and 1: the mean transmission
+* along shadow rays to points spread over the light. The points follow the Sobol
+* sequence, whose first 2^k points are stratified, scrambled per hit by XOR with
+* random bits so that neighbouring pixels see different, uncorrelated patterns.
+* The first two rays go to opposite quarters of the light; if they agree, the hit
+* is taken to be fully lit or fully shadowed. Only in the penumbra are the rest of
+* the light's samples cast.
+*/
+static float softShadow(const CompiledScene& scene, const Light& light, glm::vec3 hit, std::vector<int>* occluders)
+{
+	uint32_t bits[3];
+	memcpy(bits, &hit, 3 * sizeof(float));
+	uint32_t scrambleX = hash(bits[0] ^ hash(bits[1] ^ hash(bits[2])));
+	uint32_t scrambleY = hash(scrambleX);
+
+	float sum = 0, first = 0;
+	int n = 0;
+	int count = (light.samples < 2) ? light.samples : 2;
+	while (n < count)
+	{
+		uint32_t x, y;
+		sobol(n, x, y);
+		float u = ((x ^ scrambleX) >> 8) * (1.0f / 16777216), v = ((y ^ scrambleY) >> 8) * (1.0f / 16777216);
+		glm::vec3 toSample = light.samplePoint(hit, u, v) - hit;
+		float dist = glm::length(toSample);
+		float t = transmission(scene.occlusion(hit, toSample / dist, dist, occluders));
+		if (n == 0) first = t;
+		else if (t != first) count = light.samples;		//In the penumbra
+		sum += t;
+		n++;
+	}
+	return sum / n;
+}
+
+//Where the ray (p0, dir) leaves box, or p0 if it never passes through the box
+static glm::vec3 clipToBox(glm::vec3 p0, glm::vec3 dir, const AABB& box)
+{
+	float tmin = 0, tmax = 1.e+30f;
+	for (int a = 0; a < 3; a++)
+	{
+		if (dir[a] == 0)
+		{
+			if (p0[a] < box.min[a] || p0[a] > box.max[a]) return p0;
+			continue;
+		}
+		float t1 = (box.min[a] - p0[a]) / dir[a], t2 = (box.max[a] - p0[a]) / dir[a];
+		tmin = glm::max(tmin, glm::min(t1, t2));
+		tmax = glm::min(tmax, glm::max(t1, t2));
+	}
+	return (tmin <= tmax) ? p0 + tmax * dir : p0;
+}
+
+/**
+* Decides whether a spawned ray is worth tracing. Rays below the minimum weight are
+* either dropped, or kept with probability weight / minWeight at weight minWeight,
+* which leaves the expected pixel colour unchanged. The random number is a hash
+* of the ray, so a render is repeatable whatever the tiles and threads.
+*/
+bool WavefrontTracer::survives(PathRay& ray, const ShadingParams& params) const
+{
+	float weight = fabs(ray.weight);		//Fog can make weights negative
+	if (weight >= params.minWeight) return true;
+	if (!params.roulette || weight == 0) return false;
+	uint32_t bits[4];
+	memcpy(bits, &ray.p0, 3 * sizeof(float));
+	memcpy(bits + 3, &ray.dir.x, sizeof(float));
+	uint32_t h = hash(bits[0] ^ hash(bits[1] ^ hash(bits[2] ^ hash(bits[3] + ray.step))));
+	float u = (h >> 8) * (1.0f / 16777216);		//[0, 1)
+	if (u * params.minWeight >= weight) return false;
+	ray.weight = (ray.weight < 0) ? -params.minWeight : params.minWeight;
+	return true;
+}
+
+//Finds the closest hit of every ray, a packet at a time, into hitIndex_ and hitDist_
+void WavefrontTracer::intersect(const std::vector<PathRay>& rays, const ShadingParams& params)
+{
+	hitIndex_.resize(rays.size());
+	hitDist_.resize(rays.size());
+	RayPacket packet;
+	for (size_t i0 = 0; i0 < rays.size(); i0 += MAX_PACKET)
+	{
+		packet.count = (rays.size() - i0 < (size_t)MAX_PACKET) ? rays.size() - i0 : MAX_PACKET;
+		for (int k = 0; k < packet.count; k++)
+		{
+			const PathRay& ray = rays[i0 + k];
+			packet.ox[k] = ray.p0.x;  packet.oy[k] = ray.p0.y;  packet.oz[k] = ray.p0.z;
+			packet.dx[k] = ray.dir.x; packet.dy[k] = ray.dir.y; packet.dz[k] = ray.dir.z;
+		}
+		params.packetTracer->closestPt(packet);
+		for (int k = 0; k < packet.count; k++)
+		{
+			hitIndex_[i0 + k] = packet.index[k];
+			hitDist_[i0 + k] = packet.dist[k];
+		}
+	}
+}
+
+//Shades the intersected rays of the current wave: queues their light visibility tests
+//and spawns their reflected, transparent and refracted rays
+void WavefrontTracer::shadePaths(const ShadingParams& params, glm::vec3* pixels, int* objectIds)
+{
+	const CompiledScene& scene = *params.scene;
+	for (size_t i = 0; i < paths_.size(); i++)
+	{
+		const PathRay& path = paths_[i];
+		if (objectIds != nullptr && path.step == 1) objectIds[path.pixel] = hitIndex_[i];
+		if (hitIndex_[i] == -1)
+		{
+			pixels[path.pixel] += path.weight * params.background;		//no intersection
+			if (record_ != nullptr)
+			{
+				record_->pathBounds[path.pixel].expand(path.p0);
+				record_->pathBounds[path.pixel].expand(clipToBox(path.p0, path.dir, record_->sceneBox));
+			}
+			continue;
+		}
+
+		Ray ray;
+		ray.p0 = path.p0;
+		ray.dir = path.dir;
+		ray.index = hitIndex_[i];
+		ray.dist = hitDist_[i];
+		ray.hit = ray.p0 + ray.dir * ray.dist;
+		ray.width = path.width;
+		ray.spread = path.spread;
+
+		const Material& mat = scene.getMaterial(ray.index);
+		glm::vec3 normalVec = scene.normal(ray.index, ray.hit);
+		if (record_ != nullptr)
+		{
+			record_->touched.push_back(std::make_pair(path.pixel, ray.index));
+			record_->pathBounds[path.pixel].expand(ray.p0);
+			record_->pathBounds[path.pixel].expand(ray.hit);
+			record_->hitBounds[path.pixel].expand(ray.hit);
+		}
+
+		//Fog scales everything seen at this hit and adds a constant
+		float weight = path.weight;
+		if (params.fog)
+		{
+			float t = (ray.hit.z - params.fogZ[0]) / (params.fogZ[1] - params.fogZ[0]);
+			float s = (ray.hit.y - params.fogY[0]) / (params.fogY[1] - params.fogY[0]);
+			pixels[path.pixel] += weight * (s * t) * glm::vec3(1);
+			weight *= 2 - s - t;
+		}
+
+		ShadowRecord record;
+		record.hit = ray.hit;
+		record.normal = normalVec;
+		record.viewDir = -ray.dir;
+		record.surfaceCol = surfaceColor[mat.mapping](mat, ray, normalVec, params);
+		record.weight = weight;
+		record.object = ray.index;
+		record.pixel = path.pixel;
+		record.primary = (path.step == 1);
+		shadows_.push_back(record);
+
+		if (path.step >= params.maxSteps) continue;
+
+		//reflection ray
+		if (mat.refl && (!mat.reflfront || normalVec.z > 0))
+		{
+			PathRay reflected = spawn(path, ray.dist, ray.hit, glm::reflect(ray.dir, normalVec), weight * mat.reflc);
+			if (survives(reflected, params)) next_.push_back(reflected);
+		}
+
+		//straight transparent ray
+		if (mat.tran && !mat.refr)
+		{
+			PathRay transparent = spawn(path, ray.dist, ray.hit, ray.dir, weight * mat.tranc);
+			if (survives(transparent, params)) next_.push_back(transparent);
+		}
+
+		//refracted ray: travels to the far side of the object first
+		if (mat.refr && mat.tran)
+		{
+			PathRay inside = spawn(path, ray.dist, ray.hit, glm::refract(ray.dir, normalVec, 1 / mat.refri), weight * mat.refrc);
+			inside.step = path.step;
+			inside.object = ray.index;
+			if (survives(inside, params)) interior_.push_back(inside);
+		}
+	}
+}
+
+//Refracts the interior rays out of the far side of their objects, into the next wave.
+//The exit point and its normal come from the object itself, not from a scene search.
+void WavefrontTracer::leaveInterior(const ShadingParams& params)
+{
+	for (size_t i = 0; i < interior_.size(); i++)
+	{
+		const PathRay& ray = interior_[i];
+		glm::vec3 m;
+		float dist = params.scene->exit(ray.object, ray.p0, ray.dir, m);
+		if (dist <= 0)		//No far side (e.g. a plane): the ray carries on as it is
+		{
+			PathRay out = ray;
+			out.step = ray.step + 1;
+			out.object = -1;
+			next_.push_back(out);
+			continue;
+		}
+		glm::vec3 hit = ray.p0 + ray.dir * dist;
+		if (record_ != nullptr) record_->pathBounds[ray.pixel].expand(hit);
+		const Material& mat = params.scene->getMaterial(ray.object);
+		glm::vec3 h = glm::refract(ray.dir, -m, mat.refri);
+		next_.push_back(spawn(ray, dist, hit, h, ray.weight));
+	}
+	interior_.clear();
+}
+
+//Lighting of the queued hits. Lights that cannot reach a hit (out of range, or outside
+//a spot light's cone), or that are behind its surface, are rejected before any shadow
+//ray is cast. A transparent object lets 60% of a light through; an opaque one none.
+//Area lights are partly visible in their penumbra (see softShadow()).
+void WavefrontTracer::shadeShadows(const ShadingParams& params, glm::vec3* pixels)
+{
+	const CompiledScene& scene = *params.scene;
+	const std::vector<Light>& lights = *params.lights;
+	for (size_t i = 0; i < shadows_.size(); i++)
+	{
+		const ShadowRecord& rec = shadows_[i];
+		const Material& mat = scene.getMaterial(rec.object);
+		glm::vec3 color = mat.ambient(rec.surfaceCol);
+
+		bool culled = rec.primary && params.primaryLights != nullptr;
+		int numLights = culled ? params.primaryLights->size() : lights.size();
+		for (int k = 0; k < numLights; k++)
+		{
+			int lightIndex = culled ? (*params.primaryLights)[k] : k;
+			const Light& light = lights[lightIndex];
+			glm::vec3 lightVec;
+			float dist, attenuation;
+			if (!light.illuminates(rec.hit, lightVec, dist, attenuation)) continue;
+			if (record_ != nullptr) record_->touched.push_back(std::make_pair(rec.pixel, -1 - lightIndex));
+			if (glm::dot(lightVec, rec.normal) <= 0) continue;
+
+			std::vector<int>* occluders = (record_ != nullptr) ? &occluders_ : nullptr;
+			occluders_.clear();
+			attenuation *= light.isArea() ? softShadow(scene, light, rec.hit, occluders) : transmission(scene.occlusion(rec.hit, lightVec, dist, occluders));
+			for (size_t j = 0; j < occluders_.size(); j++) record_->touched.push_back(std::make_pair(rec.pixel, occluders_[j]));
+			if (attenuation == 0) continue;
+			color += attenuation * mat.lighting(rec.normal, lightVec, light.color, rec.viewDir, rec.surfaceCol);
+		}
+
+		pixels[rec.pixel] += rec.weight * color;
+	}
+	shadows_.clear();
+}
+
+/**
+* Traces the primary rays and adds the colour each one sees, times its weight,
+* to pixels[ray.pixel]. The pixels are not cleared first. If objectIds is given,
+* objectIds[ray.pixel] is set to the object each primary ray hits (-1 if none).
+* If record is given, what each pixel's rays touch is added to it; it must have
+* been cleared for as many pixels as the rays use.
+*/
+void WavefrontTracer::trace(const std::vector<PathRay>& primary, const ShadingParams& params, glm::vec3* pixels, int* objectIds, PixelRecord* record)
+{
+	record_ = record;
+	paths_ = primary;
+	while (!paths_.empty())
+	{
+		intersect(paths_, params);
+		shadePaths(params, pixels, objectIds);
+		if (!interior_.empty()) leaveInterior(params);
+		shadeShadows(params, pixels);
+		paths_.swap(next_);
+		next_.clear();
+	}
+	record_ = nullptr;
+}
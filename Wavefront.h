@@ -0,0 +1,115 @@
+/*----------------------------------------------------------
+* COSC363  Ray Tracer
+*
+*  The wavefront tracer class
+*  Traces a batch of primary rays without recursion. Rays
+*  wait in queues by kind, and each queue is processed in
+*  bulk by its own kernel:
+*   - path rays are intersected in packets and shaded; the
+*     reflected, transparent and refracted rays they spawn
+*     join the next wave,
+*   - interior rays travel inside a refractive object to its
+*     far side, where they leave as path rays,
+*   - shadow records are shaded hits waiting for the light
+*     visibility tests that finish their lighting.
+*  Every ray carries the weight with which its colour adds to
+*  its pixel, so colours are accumulated into the pixels
+*  instead of being returned up a chain of recursive calls,
+*  and rays that would add next to nothing can be culled.
+-------------------------------------------------------------*/
+
+#ifndef H_WAVEFRONT
+#define H_WAVEFRONT
+
+#include <glm/glm.hpp>
+#include <vector>
+#include <utility>
+#include "CompiledScene.h"
+#include "RayPacket.h"
+#include "Texture.h"
+#include "Light.h"
+#include "AABB.h"
+
+//Everything shading needs besides the geometry: lights, fog, background and textures
+struct ShadingParams
+{
+	const CompiledScene* scene = nullptr;
+	PacketTracer* packetTracer = nullptr;
+	const std::vector<const Texture*>* textures = nullptr;	//Indexed by Material::texture
+	glm::vec3 background = glm::vec3(1);
+	const std::vector<Light>* lights = nullptr;
+	const std::vector<int>* primaryLights = nullptr;	//Indices of the lights that can reach primary hits; null for all
+	bool fog = false;					//Fade towards white between the planes z1, z2 and y1, y2
+	float fogZ[2] = { 0, 0 };
+	float fogY[2] = { 0, 0 };
+	int maxSteps = 4;					//Primary rays are step 1; no rays are spawned beyond maxSteps
+	float minWeight = 0;				//Rays whose weight falls below this are culled...
+	bool roulette = true;				//...by Russian roulette (unbiased), or else simply dropped
+};
+
+//A ray waiting to be intersected, and where its colour goes
+struct PathRay
+{
+	glm::vec3 p0;
+	glm::vec3 dir;						//Unit direction
+	float width = 0;					//Ray cone (see Ray)
+	float spread = 0;
+	float weight = 1;					//Factor on the ray's colour in its pixel
+	int pixel = 0;						//Index into the pixels passed to trace()
+	int step = 1;
+	int object = -1;					//Interior rays: the object the ray is inside
+};
+
+//A shaded hit whose light visibility is still to be tested
+struct ShadowRecord
+{
+	glm::vec3 hit;
+	glm::vec3 normal;
+	glm::vec3 viewDir;
+	glm::vec3 surfaceCol;
+	float weight;
+	int object;
+	int pixel;
+	bool primary;						//Hit by a primary ray: only primaryLights can reach it
+};
+
+//What the rays of each pixel touched, so that a scene change need only re-trace the
+//pixels it can affect (see DirtyTracker). Pixels are indices into trace()'s pixels.
+struct PixelRecord
+{
+	std::vector<std::pair<int, int>> touched;	//(pixel, object) for objects hit or shadowing a hit, (pixel, -1 - light) for lights reaching a hit
+	std::vector<AABB> pathBounds;				//By pixel: box around its view, reflected and refracted ray segments
+	std::vector<AABB> hitBounds;				//By pixel: box around the points it shaded
+	AABB sceneBox;								//Rays that leave the scene are recorded up to this box
+
+	void clear(int numPixels)
+	{
+		touched.clear();
+		pathBounds.assign(numPixels, AABB());
+		hitBounds.assign(numPixels, AABB());
+	}
+};
+
+class WavefrontTracer
+{
+private:
+	std::vector<PathRay> paths_;		//The current wave
+	std::vector<PathRay> next_;			//Rays spawned for the next wave
+	std::vector<PathRay> interior_;
+	std::vector<ShadowRecord> shadows_;
+	std::vector<int> hitIndex_;			//Compact hit records of the rays being intersected
+	std::vector<float> hitDist_;
+	PixelRecord* record_ = nullptr;		//Where the current trace() notes what it touches, if anywhere
+	std::vector<int> occluders_;
+
+	void intersect(const std::vector<PathRay>& rays, const ShadingParams& params);
+	bool survives(PathRay& ray, const ShadingParams& params) const;
+	void shadePaths(const ShadingParams& params, glm::vec3* pixels, int* objectIds);
+	void leaveInterior(const ShadingParams& params);
+	void shadeShadows(const ShadingParams& params, glm::vec3* pixels);
+
+public:
+	void trace(const std::vector<PathRay>& primary, const ShadingParams& params, glm::vec3* pixels, int* objectIds = nullptr, PixelRecord* record = nullptr);
+};
+
+#endif //!H_WAVEFRONT